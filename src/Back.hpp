@@ -0,0 +1,144 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Reverse tracing by reciprocity, for few receivers and many candidate transmitters. Rays are launched evenly from
+// each receiver instead, and every candidate transmitter holds a reception sphere of radius pole.length. A reverse ray
+// passing through a sphere has found a path between the two. The path is turned around, and its field evaluated
+// forward from the transmitter with the transmitter's pattern and polarization, through the same interactions. So one
+// reverse trace per receiver replaces one forward trace per transmitter.
+//
+// Each arrival is weighted so that the channel matches what a forward trace collects in the receiver sphere. A forward
+// launch of power P leaves P s(d) / mean(s) per unit of solid angle, and a reception sphere of radius r catches a
+// solid angle of pi r^2 / L^2. Reverse rays are caught by the transmitter sphere of radius R, each standing for
+// 4 pi / N of solid angle. An arrival therefore carries P s(d) / mean(s) / N * r^2 / R^2, with the pattern mean over
+// the same N directions.
+//
+// channels[t] holds the receivers as a forward trace of transmitter t would leave them, including delay bins, taps and
+// arrival and departure sectors. Only reflection and refraction are followed, as in Nrcc's streaming trace.
+
+#ifndef NARCCISSUS_BACK_HPP
+#define NARCCISSUS_BACK_HPP
+
+#include "Mesh.hpp"
+#include "Nrcc.hpp"
+#include "Pole.hpp"
+#include "Taps.hpp"
+
+template<typename type>
+class Back {
+    using cmpx = std::complex<type>;
+    using VecC = Vec3<cmpx>;
+    using Vec3 = Vec3<type>;
+    using Face = Face<type>;
+    using Wave = Wave<type>;
+    using Pole = Pole<type>;
+    using Taps = Taps<type>;
+
+public:
+    // VARIABLES
+    std::vector<Pole> transmitters;
+    std::vector<std::vector<Taps>> channels;
+
+    type power = 1;
+    type delay = 0;
+    type scaling = 2;
+
+    uint64_t arrivals = 0;
+
+    // METHODS
+    template<typename Scene>
+    void trace(Scene &scene, const std::vector<Taps> &receivers, const int &accuracy, const uint8_t &rs) {
+        channels.assign(transmitters.size(), receivers);
+        for (auto &channel: channels) {
+            for (auto &receiver: channel) receiver.clear();
+        }
+        arrivals = 0;
+
+        std::vector<Vec3> directions = nrcc::icosphere<type>(accuracy);
+
+        means.assign(transmitters.size(), 0);
+        for (uint64_t t = 0; t < transmitters.size(); t++) {
+            for (const auto &direction: directions) means[t] += scale(transmitters[t], direction);
+            means[t] /= directions.size();
+        }
+
+        for (uint64_t r = 0; r < receivers.size(); r++) {
+            const Pole &rx = receivers[r].pole;
+            for (const auto &direction: directions) {
+                Wave wave = {rx.coordinates, direction, rx.frequency, 1, 0, rx.orientation.cmpx()};
+                follow(wave, scene, r, directions.size(), rs);
+            }
+        }
+    }
+
+    // CONSTRUCTORS
+    Back() = default;
+
+    explicit Back(const std::vector<Pole> &transmitters) : transmitters(transmitters) {}
+
+private:
+    Nrcc<type> tracer;
+    std::vector<type> means;
+
+    type scale(const Pole &pole, const Vec3 &direction) const {
+        if (pole.pattern != nullptr) return pole.pattern->gain(direction);
+        return pow(cross(direction, pole.orientation).norm() / direction.norm() * pole.orientation.norm(), scaling);
+    }
+
+    template<typename Scene>
+    void follow(Wave &wave, Scene &scene, const uint64_t &r, const uint64_t &launched, const uint8_t &rs) {
+        type min_distance;
+        Face *hit_face = tracer.closest(wave, scene, min_distance);
+
+        for (uint64_t t = 0; t < transmitters.size(); t++) {
+            const Pole &tx = transmitters[t];
+            type d = nrcc::intersectionDistance(wave.origin, wave.direct, tx.coordinates, tx.length);
+            if (d > 0 && d < min_distance) arrive(wave, t, r, launched);
+        }
+
+        if (hit_face == nullptr || rs == 0) return;
+
+        Wave reflect_wave = tracer.reflectedWave(wave, *hit_face);
+        Wave refract_wave = tracer.refractedWave(wave, *hit_face);
+
+        follow(reflect_wave, scene, r, launched, rs - 1);
+        follow(refract_wave, scene, r, launched, rs - 1);
+    }
+
+    // Turns the reverse path ending in "wave" around and evaluates it forward from transmitter t to receiver r.
+    void arrive(const Wave &wave, const uint64_t &t, const uint64_t &r, const uint64_t &launched) {
+        const Pole &tx = transmitters[t];
+        Taps &receiver = channels[t][r];
+
+        std::vector<const Wave *> chain;
+        for (const Wave *w = &wave; w != nullptr; w = w->genesis.wave) chain.push_back(w);
+
+        // Forward points: the transmitter, the interactions from last to first, then the receiver.
+        std::vector<Vec3> points = {tx.coordinates};
+        for (const Wave *w: chain) points.push_back(w->origin);
+        points.back() = receiver.pole.coordinates;
+
+        Vec3 departure = (points[1] - points[0]).unit();
+        type r2 = receiver.pole.length * receiver.pole.length;
+        type amplitude = power * scale(tx, departure) / means[t] / launched * r2 / (tx.length * tx.length);
+        VecC polar = tx.pattern != nullptr ? tx.pattern->polarization(departure) : tx.orientation.cmpx();
+
+        std::vector<Wave> path;
+        path.reserve(chain.size());
+        path.push_back({points[0], departure, tx.frequency, amplitude, delay, polar});
+        for (uint64_t i = 1; i < chain.size(); i++) {
+            // Interaction i forward is the origin of reverse wave i - 1, created at its genesis face.
+            const Wave *w = chain[i - 1];
+            path.push_back({points[i], (points[i + 1] - points[i]).unit(), &path.back(), w->genesis.face,
+                            w->genesis.interaction});
+        }
+
+        Wave &last = path.back();
+        type length = 0;
+        for (uint64_t i = 0; i + 1 < points.size(); i++) length += range(points[i], points[i + 1]);
+
+        receiver.add(last.electricField(range(last.origin, points.back())), length, last.direct * -1, departure);
+        arrivals++;
+    }
+};
+
+#endif //NARCCISSUS_BACK_HPP
@@ -0,0 +1,226 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Beam tracing. Instead of single rays, the triangles of an icosphere are launched as triangular ray tubes: an apex and
+// three edge directions. A tube is followed by its three corner rays and its centre ray. When all four hit the same face
+// (or all escape) the tube is resolved whole, otherwise it is split into four along the midpoints of its edges, down to
+// "splits" levels, so tubes divide where they cross face boundaries. A tube still mixed at the last level follows its
+// centre ray.
+//
+// A receiver is credited when its centre lies inside a resolved tube, between the plane the tube starts from and the
+// face it ends on. Reflected tubes keep the mirrored apex, an image source, so the path to a credited receiver is found
+// exactly by unfolding the images back through the faces, and is checked against the mesh segment by segment. Small
+// objects that no corner ray saw thus still block it. Polarization and Fresnel coefficients come from Wave along that
+// path. Only specular reflection is followed: refraction and diffraction do not keep a tube's rays concurrent.
+//
+// Spreading loss follows the tube cross-section, which grows with the square of the unfolded path length L. A tube of
+// solid angle W launched with a share P of the power lands P / (W L^2) per unit area, scaled here by the disc area
+// pi r^2 of the reception sphere. That is the power infinitely dense rays would deposit in the sphere, but not their
+// field: the rays a sphere many wavelengths across catches arrive with mixed phases, while a beam evaluates each path
+// at the centre. Beam fields thus match the image method, to rounding in the canyon of test_beam once there are enough
+// tubes (320) that no path slips between the corner rays of a resolved tube. Ray traced fields in 2 m spheres at
+// 2.4 GHz stay up to about 10 dB off it near interference nulls, however many rays are launched.
+
+#ifndef NARCCISSUS_BEAM_HPP
+#define NARCCISSUS_BEAM_HPP
+
+#include "Mesh.hpp"
+#include "Wave.hpp"
+#include "Pole.hpp"
+#include "Taps.hpp"
+
+template<typename type>
+class Beam {
+    using cmpx = std::complex<type>;
+    using VecC = Vec3<cmpx>;
+    using Vec3 = Vec3<type>;
+    using Face = Face<type>;
+    using Wave = Wave<type>;
+    using Pole = Pole<type>;
+    using Taps = Taps<type>;
+    using Mesh = Mesh<type>;
+
+public:
+    // A ray tube. apexes holds the source followed by its image after each reflection, faces the faces reflected from.
+    struct Tube {
+        std::vector<Vec3> apexes;
+        std::vector<Face *> faces;
+        std::array<Vec3, 3> edges;
+        uint8_t rs;
+        uint64_t level;
+    };
+
+    // VARIABLES
+    uint64_t splits = 5;
+
+    // Statistics of the last trace: tubes resolved, splits made and receptions credited.
+    uint64_t resolved = 0;
+    uint64_t divided = 0;
+    uint64_t credited = 0;
+
+    // METHODS
+    // Launches the icosphere triangles of the given accuracy from the pole and credits the receivers.
+    void trace(const Pole &pole, const type &power, const type &delay, const type &scaling_factor, const int &accuracy,
+               Mesh &mesh, std::vector<Taps> &receivers, const uint8_t &rs) {
+        resolved = 0;
+        divided = 0;
+        credited = 0;
+
+        std::vector<std::array<uint64_t, 3>> triangles;
+        std::vector<Vec3> vertices = nrcc::icosphere<type>(accuracy, triangles);
+
+        // Power is shared by pattern over solid angle, as Pole::transmit shares it over rays.
+        type norm = 0;
+        for (const auto &t: triangles) {
+            std::array<Vec3, 3> edges = {vertices[t[0]], vertices[t[1]], vertices[t[2]]};
+            norm += scale(pole, scaling_factor, centre(edges)) * solidAngle(edges);
+        }
+
+        Source source = {pole, power / norm, delay, scaling_factor};
+        for (const auto &t: triangles) {
+            follow(source, {{pole.coordinates}, {}, {vertices[t[0]], vertices[t[1]], vertices[t[2]]}, rs, 0}, mesh,
+                   receivers);
+        }
+    }
+
+    static type solidAngle(const std::array<Vec3, 3> &e) {
+        type triple = std::abs(dot(e[0], cross(e[1], e[2])));
+        return 2 * std::atan2(triple, 1 + dot(e[0], e[1]) + dot(e[1], e[2]) + dot(e[2], e[0]));
+    }
+
+private:
+    struct Source {
+        const Pole &pole;
+        type density;
+        type delay;
+        type scaling;
+    };
+
+    static Vec3 centre(const std::array<Vec3, 3> &e) {
+        return (e[0] + e[1] + e[2]).unit();
+    }
+
+    static type scale(const Pole &pole, const type &scaling_factor, const Vec3 &direction) {
+        if (pole.pattern != nullptr) return pole.pattern->gain(direction);
+        return pow(cross(direction, pole.orientation).norm() / direction.norm() * pole.orientation.norm(),
+                   scaling_factor);
+    }
+
+    static Vec3 mirror(const Vec3 &point, const Face &face) {
+        Vec3 n = face.normal();
+        return point - n * (dot(point - face.points[0], n) * 2);
+    }
+
+    static Vec3 reflect(const Vec3 &direct, const Face &face) {
+        Vec3 n = face.normal();
+        return direct - n * (dot(direct, n) * 2);
+    }
+
+    // Distance from an origin along a direction to the plane of a face, infinite if parallel.
+    static type plane(const Vec3 &origin, const Vec3 &direct, const Face &face) {
+        Vec3 n = face.normal();
+        type d = dot(direct, n);
+        return d == 0 ? nrcc::infinity : dot(face.points[0] - origin, n) / d;
+    }
+
+    // Where a tube ray starts: at the apex, or for reflected tubes on the plane of the last face.
+    static type start(const Tube &tube, const Vec3 &direct) {
+        return tube.faces.empty() ? 0 : plane(tube.apexes.back(), direct, *tube.faces.back());
+    }
+
+    void follow(const Source &source, const Tube &tube, Mesh &mesh, std::vector<Taps> &receivers) {
+        const Vec3 &apex = tube.apexes.back();
+
+        std::array<Vec3, 4> directs = {tube.edges[0], tube.edges[1], tube.edges[2], centre(tube.edges)};
+        std::array<typename Mesh::Hit, 4> hits;
+        for (int i = 0; i < 4; i++) hits[i] = mesh.intersect(apex + directs[i] * start(tube, directs[i]), directs[i]);
+
+        auto same = [](const typename Mesh::Hit &a, const typename Mesh::Hit &b) {
+            bool miss_a = a.distance == nrcc::infinity;
+            bool miss_b = b.distance == nrcc::infinity;
+            return miss_a == miss_b && (miss_a || (a.group == b.group && a.index == b.index));
+        };
+
+        if (tube.level < splits && !(same(hits[0], hits[3]) && same(hits[1], hits[3]) && same(hits[2], hits[3]))) {
+            divided++;
+            const auto &e = tube.edges;
+            Vec3 m01 = (e[0] + e[1]).unit();
+            Vec3 m12 = (e[1] + e[2]).unit();
+            Vec3 m20 = (e[2] + e[0]).unit();
+            for (const auto &edges: {std::array<Vec3, 3>{e[0], m01, m20}, std::array<Vec3, 3>{m01, e[1], m12},
+                                     std::array<Vec3, 3>{m20, m12, e[2]}, std::array<Vec3, 3>{m01, m12, m20}}) {
+                follow(source, {tube.apexes, tube.faces, edges, tube.rs, tube.level + 1}, mesh, receivers);
+            }
+            return;
+        }
+
+        resolved++;
+        Face *hit = hits[3].distance == nrcc::infinity ? nullptr : &mesh.face(hits[3]);
+
+        for (auto &receiver: receivers) credit(source, tube, hit, mesh, receiver);
+
+        if (hit == nullptr || tube.rs == 0) return;
+
+        Tube reflected = {tube.apexes, tube.faces, {}, static_cast<uint8_t>(tube.rs - 1), tube.level};
+        reflected.apexes.push_back(mirror(apex, *hit));
+        reflected.faces.push_back(hit);
+        for (int i = 0; i < 3; i++) reflected.edges[i] = reflect(tube.edges[i], *hit);
+        follow(source, reflected, mesh, receivers);
+    }
+
+    void credit(const Source &source, const Tube &tube, const Face *end, Mesh &mesh, Taps &receiver) {
+        const Vec3 &apex = tube.apexes.back();
+        const Vec3 &target = receiver.pole.coordinates;
+        const auto &e = tube.edges;
+
+        // Inside the cone of the tube when the receiver is a non negative combination of its edges.
+        Vec3 v = target - apex;
+        type det = dot(e[0], cross(e[1], e[2]));
+        type a = dot(v, cross(e[1], e[2])) / det;
+        type b = dot(e[0], cross(v, e[2])) / det;
+        type c = dot(e[0], cross(e[1], v)) / det;
+        if (a < 0 || b < 0 || c < 0) return;
+
+        type length = v.norm();
+        Vec3 direct = v / length;
+        if (start(tube, direct) >= length) return;
+        if (end != nullptr && plane(apex, direct, *end) <= length) return;
+
+        // Unfold the images back to the source, finding the reflection points.
+        uint64_t k = tube.faces.size();
+        std::vector<Vec3> points(k + 2);
+        points[k + 1] = target;
+        for (uint64_t i = k; i > 0; i--) {
+            const Face &face = *tube.faces[i - 1];
+            Vec3 towards = (points[i + 1] - tube.apexes[i]).unit();
+            type t = nrcc::intersectionDistance(tube.apexes[i], towards, face);
+            if (t <= 0) return;
+            points[i] = tube.apexes[i] + towards * t;
+        }
+        points[0] = tube.apexes[0];
+
+        for (uint64_t i = 0; i <= k; i++) {
+            if (mesh.occluded(points[i], points[i + 1])) return;
+        }
+
+        // Field along the path: the launch carries the power density at the receiver, reflections apply Fresnel.
+        const Pole &pole = source.pole;
+        Vec3 departure = (points[1] - points[0]).unit();
+        type amplitude = source.density * scale(pole, source.scaling, departure) / (length * length) * nrcc::pi *
+                         receiver.pole.length * receiver.pole.length;
+        VecC polar = pole.pattern != nullptr ? pole.pattern->polarization(departure) : pole.orientation.cmpx();
+
+        std::vector<Wave> path;
+        path.reserve(k + 1);
+        path.push_back({points[0], departure, pole.frequency, amplitude, source.delay, polar});
+        for (uint64_t i = 1; i <= k; i++) {
+            path.push_back({points[i], (points[i + 1] - points[i]).unit(), &path.back(), tube.faces[i - 1],
+                            nrcc::reflection});
+        }
+
+        Wave &last = path.back();
+        receiver.add(last.electricField(range(last.origin, target)), length, last.direct * -1, departure);
+        credited++;
+    }
+};
+
+#endif //NARCCISSUS_BEAM_HPP
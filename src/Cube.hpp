@@ -0,0 +1,245 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// First hit buffer for the rays launched from a transmitter. All of them start at one point, so their first hits are
+// found together by rasterizing the mesh onto a cube map around that point: six square faces of resolution by
+// resolution texels, each texel a small pyramid of directions. A texel stores the hit of its centre direction, the
+// group, index and distance of the nearest face, or an infinite distance where every direction escapes.
+//
+// Rasterization is conservative. A face is clipped in front of each cube face, projected, and counted in every texel
+// its polygon overlaps at all. A texel is resolved only when one face covers it completely and every other face
+// overlapping it lies entirely behind that one over the texel. Along directions through the cube face the depth of a
+// plane is the reciprocal of a linear function, so its extremes over a texel are at the four corners. Texels along
+// face borders or silhouettes are left unresolved and their rays take the exact intersection, so first() returns
+// exactly what Mesh::intersect() would.
+//
+// Nrcc::closest accepts a Cube as a scene: waves without a parent leaving the centre look up the buffer, all others
+// intersect the mesh. The mesh must not change while the buffer is in use.
+
+#ifndef NARCCISSUS_CUBE_HPP
+#define NARCCISSUS_CUBE_HPP
+
+#include <atomic>
+#include "Mesh.hpp"
+
+template<typename type>
+class Cube {
+    using Vec3 = Vec3<type>;
+    using Face = Face<type>;
+    using Mesh = Mesh<type>;
+    using Hit = typename Mesh::Hit;
+    using Point = std::array<type, 2>;
+
+public:
+    // VARIABLES
+    Mesh &mesh;
+    Vec3 centre;
+    uint64_t resolution;
+
+    // Texels of face 2 * axis + (direction negative), by rows. Unresolved texels have a negative distance.
+    std::vector<Hit> texels;
+
+    // Statistics of first(): lookups answered from the buffer and rays passed to the mesh. Atomic, as first() may be
+    // called from several threads at once.
+    std::atomic<uint64_t> hits = 0;
+    std::atomic<uint64_t> misses = 0;
+
+    // METHODS
+    // Closest face hit by a ray before limit, as Mesh::intersect().
+    Hit first(const Vec3 &origin, const Vec3 &direct, const type &limit = nrcc::infinity) {
+        bool away = origin.x != centre.x || origin.y != centre.y || origin.z != centre.z;
+        if (away) return mesh.intersect(origin, direct, limit);
+
+        const Hit &texel = texels[lookup(direct)];
+        if (texel.distance < 0) {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return mesh.intersect(origin, direct, limit);
+        }
+        hits.fetch_add(1, std::memory_order_relaxed);
+
+        if (texel.distance == nrcc::infinity) return texel;
+
+        type distance = nrcc::intersectionDistance(origin, direct, mesh.groups[texel.group].faces[texel.index]);
+        if (distance <= nrcc::epsilon) return mesh.intersect(origin, direct, limit);
+        if (distance >= limit) return {nrcc::infinity, 0, 0};
+        return {distance, texel.group, texel.index};
+    }
+
+    // Share of the texels that are resolved.
+    type resolved() const {
+        uint64_t n = 0;
+        for (const auto &texel: texels) n += texel.distance >= 0;
+        return type(n) / texels.size();
+    }
+
+    // CONSTRUCTORS
+    Cube(Mesh &mesh, const Vec3 &centre, const uint64_t &resolution) :
+            mesh(mesh), centre(centre), resolution(resolution) {
+        uint64_t n = 6 * resolution * resolution;
+
+        // Per texel: the nearest face covering it completely and its farthest depth over the texel, and the two
+        // smallest nearest depths of any overlapping faces with the face of the smallest.
+        std::vector<Hit> full(n, {nrcc::infinity, 0, 0});
+        std::vector<Hit> near(n, {nrcc::infinity, 0, 0});
+        std::vector<type> second(n, nrcc::infinity);
+        std::vector<bool> touched(n, false);
+
+        for (uint64_t g = 0; g < mesh.groups.size(); g++) {
+            for (uint64_t i = 0; i < mesh.groups[g].faces.size(); i++) {
+                for (int f = 0; f < 6; f++) raster(mesh.groups[g].faces[i], g, i, f, full, near, second, touched);
+            }
+        }
+
+        texels.assign(n, {nrcc::infinity, 0, 0});
+        for (uint64_t t = 0; t < n; t++) {
+            if (!touched[t]) continue;
+
+            bool occluding = full[t].distance < nrcc::infinity;
+            bool same = near[t].group == full[t].group && near[t].index == full[t].index;
+            type behind = same ? second[t] : near[t].distance;
+            if (occluding && behind > full[t].distance) {
+                Vec3 q = corner(t / (resolution * resolution), (t % resolution) + 0.5,
+                                (t / resolution) % resolution + 0.5);
+                const Face &face = mesh.groups[full[t].group].faces[full[t].index];
+                texels[t] = {nrcc::intersectionDistance(centre, q.unit(), face), full[t].group, full[t].index};
+            }
+            else texels[t].distance = -1;
+        }
+    }
+
+private:
+    // Texel of a direction: the face of its largest component, then its position on that face.
+    uint64_t lookup(const Vec3 &direct) const {
+        int a = std::abs(direct.x) > std::abs(direct.y) ? (std::abs(direct.x) > std::abs(direct.z) ? 0 : 2)
+                                                        : (std::abs(direct.y) > std::abs(direct.z) ? 1 : 2);
+        int f = 2 * a + (direct.v[a] < 0);
+        type major = std::abs(direct.v[a]);
+        type u = direct.v[(a + 1) % 3] / major;
+        type v = direct.v[(a + 2) % 3] / major;
+
+        uint64_t c = std::min<uint64_t>((u + 1) / 2 * resolution, resolution - 1);
+        uint64_t r = std::min<uint64_t>((v + 1) / 2 * resolution, resolution - 1);
+        return (f * resolution + r) * resolution + c;
+    }
+
+    // Direction through texel coordinates (c, r) of face f, not normalized: its major component is one.
+    Vec3 corner(const int &f, const type &c, const type &r) const {
+        int a = f / 2;
+        Vec3 q = {0, 0, 0};
+        q.v[a] = f % 2 ? -1 : 1;
+        q.v[(a + 1) % 3] = c / resolution * 2 - 1;
+        q.v[(a + 2) % 3] = r / resolution * 2 - 1;
+        return q;
+    }
+
+    void raster(const Face &face, const uint64_t &g, const uint64_t &i, const int &f, std::vector<Hit> &full,
+                std::vector<Hit> &near, std::vector<type> &second, std::vector<bool> &touched) const {
+        int a = f / 2;
+        type s = f % 2 ? -1 : 1;
+
+        // Clip the polygon in front of the cube face, then project it onto the face.
+        std::vector<Vec3> corners = face.corners();
+        std::vector<Vec3> clipped;
+        const type front = 1e-9;
+        for (uint64_t k = 0; k < corners.size(); k++) {
+            Vec3 p = corners[k] - centre;
+            Vec3 q = corners[(k + 1) % corners.size()] - centre;
+            type zp = s * p.v[a];
+            type zq = s * q.v[a];
+            if (zp >= front) clipped.push_back(p);
+            if ((zp >= front) != (zq >= front)) clipped.push_back(p + (q - p) * ((front - zp) / (zq - zp)));
+        }
+        if (clipped.size() < 3) return;
+
+        std::vector<Point> polygon;
+        for (const auto &p: clipped) {
+            type z = s * p.v[a];
+            polygon.push_back({p.v[(a + 1) % 3] / z, p.v[(a + 2) % 3] / z});
+        }
+
+        type area = 0;
+        for (uint64_t k = 0; k < polygon.size(); k++) {
+            const Point &p = polygon[k];
+            const Point &q = polygon[(k + 1) % polygon.size()];
+            area += p[0] * q[1] - q[0] * p[1];
+        }
+        if (area < 0) std::reverse(polygon.begin(), polygon.end());
+
+        // A face seen edge on has no area to cover, but leaves every texel of its bounds unresolved.
+        bool edge_on = area == 0;
+
+        Point lower = polygon[0];
+        Point upper = polygon[0];
+        for (const auto &p: polygon) {
+            lower = {std::min(lower[0], p[0]), std::min(lower[1], p[1])};
+            upper = {std::max(upper[0], p[0]), std::max(upper[1], p[1])};
+        }
+        if (lower[0] > 1 || lower[1] > 1 || upper[0] < -1 || upper[1] < -1) return;
+
+        auto texel = [&](const type &x) {
+            return static_cast<uint64_t>(std::clamp<type>(std::floor((x + 1) / 2 * resolution), 0, resolution - 1));
+        };
+
+        Vec3 normal = cross(face.bounds[0], face.bounds[1]);
+        type offset = dot(normal, face.points[0] - centre);
+        type width = type(2) / resolution;
+        type slack = 1e-7 * width;
+
+        for (uint64_t r = texel(lower[1]); r <= texel(upper[1]); r++) {
+            for (uint64_t c = texel(lower[0]); c <= texel(upper[0]); c++) {
+                std::array<Point, 4> square = {Point{c * width - 1, r * width - 1},
+                                               Point{(c + 1) * width - 1, r * width - 1},
+                                               Point{(c + 1) * width - 1, (r + 1) * width - 1},
+                                               Point{c * width - 1, (r + 1) * width - 1}};
+
+                // Separating axes are the square's, checked by the bounds above, and the polygon's edges.
+                bool overlaps = true;
+                bool covers = true;
+                for (uint64_t k = 0; k < polygon.size() && overlaps; k++) {
+                    const Point &p = polygon[k];
+                    const Point &q = polygon[(k + 1) % polygon.size()];
+                    type length = std::hypot(q[0] - p[0], q[1] - p[1]);
+                    if (edge_on || length == 0) continue;
+                    type most = -nrcc::infinity;
+                    type least = nrcc::infinity;
+                    for (const auto &x: square) {
+                        type e = ((q[0] - p[0]) * (x[1] - p[1]) - (q[1] - p[1]) * (x[0] - p[0])) / length;
+                        most = std::max(most, e);
+                        least = std::min(least, e);
+                    }
+                    overlaps = most >= -slack;
+                    covers = covers && least > slack;
+                }
+                if (!overlaps) continue;
+                if (edge_on) covers = false;
+
+                // Depth along each corner direction, which must all see the plane in front. Depths are compared in
+                // units of the unnormalized direction, the reciprocal of a linear function over the square.
+                type nearest = nrcc::infinity;
+                type farthest = 0;
+                for (const auto &x: square) {
+                    Vec3 q = corner(f, (x[0] + 1) / width, (x[1] + 1) / width);
+                    type d = dot(normal, q);
+                    type depth = d == 0 ? -1 : offset / d;
+                    if (depth <= nrcc::epsilon) {
+                        nearest = 0;
+                        covers = false;
+                        break;
+                    }
+                    nearest = std::min(nearest, depth);
+                    farthest = std::max(farthest, depth);
+                }
+
+                uint64_t t = (f * resolution + r) * resolution + c;
+                touched[t] = true;
+                if (covers && farthest < full[t].distance) full[t] = {farthest, g, i};
+                if (nearest < near[t].distance) {
+                    second[t] = near[t].distance;
+                    near[t] = {nearest, g, i};
+                }
+                else second[t] = std::min(second[t], nearest);
+            }
+        }
+    }
+};
+
+#endif //NARCCISSUS_CUBE_HPP
@@ -0,0 +1,240 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Diffracting wedges. An edge is a segment shared by two faces (or the free border of a single face, which diffracts
+// as a half plane) together with the normals, in-face tangents and materials of both sides. Normals are oriented into
+// the exterior region, so angles about the edge are measured from face 0 through free space up to n * pi at face 1.
+//
+// edges() extracts wedges from a face set once, up front. Wedges then keeps them in their own tree with boxes grown by
+// the capture radius, so a ray only inspects edges that pass within that radius of it.
+
+#ifndef NARCCISSUS_EDGE_HPP
+#define NARCCISSUS_EDGE_HPP
+
+#include <map>
+#include "Face.hpp"
+#include "Fres.hpp"
+#include "Tree.hpp"
+
+template<typename type>
+struct Edge {
+    using cmpx = std::complex<type>;
+    using Vec3 = Vec3<type>;
+    using Face = Face<type>;
+
+    // VARIABLES
+    std::array<Vec3, 2> points;
+    std::array<Face *, 2> faces;
+    std::array<Vec3, 2> normals;
+    std::array<Vec3, 2> tangents;
+    std::array<nrcc::Materials, 2> materials;
+
+    // METHODS
+    Vec3 direct() const {
+        return (points[1] - points[0]).unit();
+    }
+
+    type length() const {
+        return range(points[0], points[1]);
+    }
+
+    // Exterior angle of the wedge over pi, "n" in UTD notation. 2 for a half plane, 1.5 for a right angled corner.
+    type wedge() const {
+        type c = std::clamp(dot(tangents[0], tangents[1]), type(-1), type(1));
+        return (2 * nrcc::pi - std::acos(c)) / nrcc::pi;
+    }
+
+    // Angle of a direction about the edge, measured from face 0 towards face 1 through the exterior.
+    type angle(const Vec3 &v) const {
+        Vec3 p = v - direct() * dot(v, direct());
+        type a = std::atan2(dot(p, normals[0]), dot(p, tangents[0]));
+        return a < 0 ? a + 2 * nrcc::pi : a;
+    }
+
+    std::array<Vec3, 2> box() const {
+        return {Vec3{std::min(points[0].x, points[1].x), std::min(points[0].y, points[1].y),
+                     std::min(points[0].z, points[1].z)},
+                Vec3{std::max(points[0].x, points[1].x), std::max(points[0].y, points[1].y),
+                     std::max(points[0].z, points[1].z)}};
+    }
+
+    // Soft and hard UTD diffraction coefficients for a ray arriving along incident and leaving along diffracted. The
+    // reflection terms are weighted by the Fresnel coefficients of the face each one belongs to (Luebbers), which
+    // reduces to the perfectly conducting wedge when both faces are metal. Distance is the range from the source to the
+    // edge and sets the transition function argument.
+    std::array<cmpx, 2> coefficients(const Vec3 &incident, const Vec3 &diffracted, const type &frequency,
+                                     const type &distance) const {
+        type k = 2 * nrcc::pi * frequency / nrcc::lightspeed;
+        type n = wedge();
+
+        type sin_b = cross(incident, direct()).norm();
+        type L = distance * sin_b * sin_b;
+
+        type phi_i = angle(incident * -1);
+        type phi_d = angle(diffracted);
+
+        std::array<cmpx, 2> r_0 = fresnel(0, std::sin(phi_i), frequency);
+        std::array<cmpx, 2> r_n = fresnel(1, std::sin(n * nrcc::pi - phi_d), frequency);
+
+        cmpx t_1 = term(phi_d - phi_i, n, k * L, 1);
+        cmpx t_2 = term(phi_d - phi_i, n, k * L, -1);
+        cmpx t_3 = term(phi_d + phi_i, n, k * L, 1);
+        cmpx t_4 = term(phi_d + phi_i, n, k * L, -1);
+
+        cmpx scale = -std::exp(cmpx(0, -nrcc::pi / 4)) / (2 * n * std::sqrt(2 * nrcc::pi * k) * sin_b);
+
+        return {scale * (t_1 + t_2 + r_n[0] * t_3 + r_0[0] * t_4),
+                scale * (t_1 + t_2 + r_n[1] * t_3 + r_0[1] * t_4)};
+    }
+
+private:
+    // cot((pi +- beta) / 2n) F(kL a+-(beta)), nudged off the shadow boundaries where the product is finite but the
+    // factors are not.
+    static cmpx term(type beta, const type &n, const type &kL, const int &sign) {
+        type arg = (nrcc::pi + sign * beta) / (2 * n);
+        if (std::fabs(std::sin(arg)) < nrcc::epsilon) {
+            beta += 1e3 * nrcc::epsilon;
+            arg = (nrcc::pi + sign * beta) / (2 * n);
+        }
+
+        type N = std::round((beta + sign * nrcc::pi) / (2 * n * nrcc::pi));
+        type c = std::cos((2 * n * nrcc::pi * N - beta) / 2);
+
+        return std::cos(arg) / std::sin(arg) * nrcc::transition(kL * 2 * c * c);
+    }
+
+    // Soft and hard reflection coefficients of a face for an incidence with cosine cos_i from its normal, from the
+    // perpendicular and parallel coefficients of the Fresnel table from free space into the face.
+    std::array<cmpx, 2> fresnel(const int &side, const type &cos_i, const type &frequency) const {
+        typename Fres<type>::Coefficients c = Fres<type>::table(nrcc::vacuum, faces[side]->material, frequency)(
+                std::fabs(cos_i));
+        return {c[0], c[1]};
+    }
+};
+
+// Extracts the diffracting wedges of a face set. Edges are matched on vertex positions rounded to tolerance. Pairs of
+// faces that are within flatness radians of coplanar do not diffract and are skipped, as are concave edges of
+// consistently wound faces. Edges held by a single face become half planes. The returned edges point into faces, which
+// must outlive them.
+template<typename type>
+std::vector<Edge<type>> edges(std::vector<Face<type>> &faces, const type &flatness = 0.01,
+                              const type &tolerance = 1e-6) {
+    using Vec3 = Vec3<type>;
+    using Key = std::array<int64_t, 6>;
+
+    auto quantize = [&](const Vec3 &p) {
+        return std::array<int64_t, 3>{std::llround(p.x / tolerance), std::llround(p.y / tolerance),
+                                      std::llround(p.z / tolerance)};
+    };
+
+    // Each edge is keyed by its ordered endpoints and records the faces using it and whether they walk it forwards.
+    std::vector<std::vector<Vec3>> corners;
+    std::map<Key, std::vector<std::array<uint64_t, 3>>> shared;
+    for (uint64_t f = 0; f < faces.size(); f++) {
+        corners.push_back(faces[f].corners());
+        uint64_t m = corners[f].size();
+        for (uint64_t i = 0; i < m; i++) {
+            std::array<int64_t, 3> a = quantize(corners[f][i]);
+            std::array<int64_t, 3> b = quantize(corners[f][(i + 1) % m]);
+            bool forward = a < b;
+            if (!forward) std::swap(a, b);
+            shared[{a[0], a[1], a[2], b[0], b[1], b[2]}].push_back({f, i, forward});
+        }
+    }
+
+    // Inward tangent from an edge towards the centroid of its (convex) face.
+    auto tangent = [&](const uint64_t &f, const uint64_t &i, const Vec3 &e) {
+        Vec3 c = {0, 0, 0};
+        for (const auto &corner: corners[f]) c = c + corner;
+        Vec3 t = c / type(corners[f].size()) - corners[f][i];
+        return (t - e * dot(t, e)).unit();
+    };
+
+    std::vector<Edge<type>> es;
+    for (const auto &[key, uses]: shared) {
+        if (uses.size() > 2) continue;
+
+        Face<type> &f0 = faces[uses[0][0]];
+        const std::vector<Vec3> &c0 = corners[uses[0][0]];
+        Vec3 p = c0[uses[0][1]];
+        Vec3 q = c0[(uses[0][1] + 1) % c0.size()];
+        Vec3 e = (q - p).unit();
+
+        Vec3 n0 = f0.normal();
+        Vec3 t0 = tangent(uses[0][0], uses[0][1], e);
+
+        if (uses.size() == 1) {
+            es.push_back({{p, q}, {&f0, &f0}, {n0, n0 * -1}, {t0, t0}, {f0.material, f0.material}});
+            continue;
+        }
+
+        Face<type> &f1 = faces[uses[1][0]];
+        Vec3 n1 = f1.normal();
+        Vec3 t1 = tangent(uses[1][0], uses[1][1], e);
+
+        if (std::acos(std::clamp(dot(t0, t1), type(-1), type(1))) > nrcc::pi - flatness) continue;
+
+        bool consistent = uses[0][2] != uses[1][2];
+        if (consistent && dot(n0, t1) > nrcc::epsilon) continue;
+
+        if (dot(n0, t1) > 0) n0 = n0 * -1;
+        if (dot(n1, t0) > 0) n1 = n1 * -1;
+
+        es.push_back({{p, q}, {&f0, &f1}, {n0, n1}, {t0, t1}, {f0.material, f1.material}});
+    }
+    return es;
+}
+
+template<typename type>
+class Wedges {
+    using Vec3 = Vec3<type>;
+    using Edge = Edge<type>;
+    using Face = Face<type>;
+
+public:
+    // VARIABLES
+    std::vector<Edge> edges;
+    Tree<type> tree;
+    type radius;
+
+    // METHODS
+    // Calls visit(edge, t) for every edge passing within radius of the ray before limit, where t is the distance along
+    // the ray of its closest approach to the edge.
+    template<typename F>
+    void near(const Vec3 &origin, const Vec3 &direct, const type &limit, F &&visit) {
+        tree.traverse(origin, direct, limit + radius, [&](const uint64_t &i, type &) {
+            Edge &edge = edges[i];
+
+            Vec3 e = edge.direct();
+            Vec3 w = origin - edge.points[0];
+
+            type b = dot(direct, e);
+            type d = dot(direct, w);
+            type c = dot(e, w);
+            type denominator = 1 - b * b;
+            if (denominator < nrcc::epsilon) return false;
+
+            type t = (b * c - d) / denominator;
+            type s = (c - b * d) / denominator;
+            if (t <= nrcc::epsilon || t >= limit || s < 0 || s > edge.length()) return false;
+
+            if ((w + direct * t - e * s).norm() < radius) visit(edge, t);
+            return false;
+        });
+    }
+
+    // CONSTRUCTORS
+    Wedges() : radius(0) {}
+
+    Wedges(std::vector<Face> &faces, const type &radius, const type &flatness = 0.01) :
+            edges(::edges(faces, flatness)),
+            radius(radius) {
+        std::vector<std::array<Vec3, 2>> boxes;
+        for (const auto &edge: edges) {
+            std::array<Vec3, 2> box = edge.box();
+            boxes.push_back({box[0] - Vec3{radius, radius, radius}, box[1] + Vec3{radius, radius, radius}});
+        }
+        tree.build(boxes);
+    }
+};
+
+#endif //NARCCISSUS_EDGE_HPP
@@ -0,0 +1,300 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Material edits without a full retrace. Changing the material of a face only changes the Fresnel coefficients of the
+// paths that interact with it, and those paths stay geometrically valid. Edit traces like Nrcc's streaming trace, but
+// keeps every received path: its launch, its face and interaction sequence, the origin and direction of each of its
+// waves and the contribution it made to its receiver. An index from every face to the paths meeting it is kept too.
+//
+// change() sets the new material and re-evaluates only the indexed paths. Each one is rebuilt as a chain of waves with
+// the stored geometry, so Wave::initializeEm computes its field again with the new coefficients, and its receiver
+// takes back the old contribution and adds the new one. Unedited paths are never touched, and a path rebuilt with
+// unchanged materials gives back exactly the field it had.
+//
+// Refraction is the exception, as the direction of a transmitted wave depends on the refractive index. Every
+// refraction is kept as an event, the launch and the sequence of interactions up to it, indexed by face. For an edited
+// face, the paths and events behind its refractions are taken back, the waves up to each refraction are rebuilt from
+// the launch, and only the refracted subtree is traced again. Events cost a launch and a few ids per face hit.
+//
+// Records and events taken back stay in place, marked dead, so indices held during a change stay valid. Once the dead
+// outnumber the live, change() compacts both and rebuilds the indices, so repeated edits do not grow memory.
+
+#ifndef NARCCISSUS_EDIT_HPP
+#define NARCCISSUS_EDIT_HPP
+
+#include <set>
+#include "Mesh.hpp"
+#include "Nrcc.hpp"
+#include "Taps.hpp"
+
+template<typename type>
+class Edit {
+    using cmpx = std::complex<type>;
+    using VecC = Vec3<cmpx>;
+    using Vec3 = Vec3<type>;
+    using Face = Face<type>;
+    using Wave = Wave<type>;
+    using Taps = Taps<type>;
+    using Mesh = Mesh<type>;
+
+public:
+    // A received path. origins and directs hold its waves from the launch on, faces and interactions the interaction
+    // that starts each wave after the first.
+    struct Record {
+        uint64_t launch;
+        uint64_t receiver;
+        std::vector<uint64_t> faces;
+        std::vector<nrcc::Interactions> interactions;
+        std::vector<Vec3> origins;
+        std::vector<Vec3> directs;
+        type distance;
+        type length;
+        Vec3 arrival;
+        Vec3 departure;
+        VecC field;
+        bool kept;
+        bool live;
+    };
+
+    // A refraction, the last of its sequence of interactions.
+    struct Event {
+        uint64_t launch;
+        std::vector<uint64_t> faces;
+        std::vector<nrcc::Interactions> interactions;
+        bool live;
+    };
+
+    // VARIABLES
+    Mesh &mesh;
+    std::vector<Taps> &receivers;
+    std::vector<Wave> launches;
+    uint8_t depth;
+
+    std::vector<Record> records;
+    std::vector<Event> events;
+
+    // Statistics of the last change(): paths re-evaluated, and refracted subtrees traced again.
+    uint64_t reevaluated = 0;
+    uint64_t retraced = 0;
+
+    // METHODS
+    void trace(const std::vector<Wave> &waves, const uint8_t &rs) {
+        launches = waves;
+        depth = rs;
+
+        records.clear();
+        events.clear();
+        dead = 0;
+        paths.assign(mesh.size(), {});
+        refractions.assign(mesh.size(), {});
+        launched.assign(launches.size(), {});
+        branched.assign(launches.size(), {});
+
+        for (uint64_t l = 0; l < launches.size(); l++) {
+            Wave wave = launches[l];
+            std::vector<uint64_t> faces;
+            std::vector<nrcc::Interactions> interactions;
+            follow(wave, l, faces, interactions, depth);
+        }
+    }
+
+    void change(const uint64_t &id, const nrcc::Materials &material) {
+        change(std::vector<uint64_t>{id}, material);
+    }
+
+    void change(const std::vector<uint64_t> &ids, const nrcc::Materials &material) {
+        std::set<uint64_t> edited(ids.begin(), ids.end());
+        for (const auto &id: edited) mesh.face(id).material = material;
+
+        // Refractions at edited faces not already inside the subtree of an earlier one.
+        std::vector<uint64_t> subtrees;
+        for (const auto &id: edited) {
+            for (const auto &e: refractions[id]) {
+                const Event &event = events[e];
+                if (!event.live) continue;
+
+                bool earliest = true;
+                for (uint64_t j = 0; j + 1 < event.faces.size(); j++) {
+                    if (event.interactions[j] == nrcc::refraction && edited.contains(event.faces[j])) earliest = false;
+                }
+                if (earliest) subtrees.push_back(e);
+            }
+        }
+
+        for (const auto &e: subtrees) prune(events[e]);
+
+        std::set<uint64_t> touched;
+        for (const auto &id: edited) {
+            for (const auto &p: paths[id]) {
+                if (records[p].live) touched.insert(p);
+            }
+        }
+        reevaluated = touched.size();
+        for (const auto &p: touched) reevaluate(records[p]);
+
+        retraced = subtrees.size();
+        for (const auto &e: subtrees) regrow(e);
+
+        if (2 * dead > records.size() + events.size()) compact();
+    }
+
+    // CONSTRUCTORS
+    Edit(Mesh &mesh, std::vector<Taps> &receivers) : mesh(mesh), receivers(receivers), depth(0) {}
+
+private:
+    Nrcc<type> tracer;
+
+    // Per face id, the records meeting the face and the events refracting through it. Per launch, its records and
+    // events.
+    std::vector<std::vector<uint64_t>> paths;
+    std::vector<std::vector<uint64_t>> refractions;
+    std::vector<std::vector<uint64_t>> launched;
+    std::vector<std::vector<uint64_t>> branched;
+
+    // Records and events no longer live.
+    uint64_t dead = 0;
+
+    void follow(Wave &wave, const uint64_t &l, std::vector<uint64_t> &faces,
+                std::vector<nrcc::Interactions> &interactions, const uint8_t &rs) {
+        typename Mesh::Hit hit = mesh.intersect(wave.origin, wave.direct);
+
+        for (uint64_t r = 0; r < receivers.size(); r++) {
+            const Pole<type> &pole = receivers[r].pole;
+            type d = nrcc::intersectionDistance(wave.origin, wave.direct, pole.coordinates, pole.length);
+            if (d > 0 && d < hit.distance) record(wave, l, r, faces, interactions);
+        }
+
+        if (hit.distance == nrcc::infinity || rs == 0) return;
+
+        Face &face = mesh.face(hit);
+        uint64_t id = mesh.id(hit);
+        faces.push_back(id);
+
+        Wave reflect_wave = tracer.reflectedWave(wave, face);
+        interactions.push_back(nrcc::reflection);
+        follow(reflect_wave, l, faces, interactions, rs - 1);
+
+        Wave refract_wave = tracer.refractedWave(wave, face);
+        interactions.back() = nrcc::refraction;
+        refractions[id].push_back(events.size());
+        branched[l].push_back(events.size());
+        events.push_back({l, faces, interactions, true});
+        follow(refract_wave, l, faces, interactions, rs - 1);
+
+        interactions.pop_back();
+        faces.pop_back();
+    }
+
+    // Adds a wave passing through receiver r to it, as Taps::receive does, and keeps it as a record.
+    void record(Wave &wave, const uint64_t &l, const uint64_t &r, const std::vector<uint64_t> &faces,
+                const std::vector<nrcc::Interactions> &interactions) {
+        Record record = {l, r, faces, interactions, {}, {}, range(wave.origin, receivers[r].pole.coordinates), 0,
+                         wave.direct * -1, {}, {}, false, true};
+
+        record.length = record.distance;
+        for (Wave *w = &wave; w != nullptr; w = w->genesis.wave) {
+            record.origins.push_back(w->origin);
+            record.directs.push_back(w->direct);
+            if (w->genesis.wave != nullptr) record.length += w->genesis.distance;
+        }
+        std::reverse(record.origins.begin(), record.origins.end());
+        std::reverse(record.directs.begin(), record.directs.end());
+        record.departure = record.directs[0];
+        record.field = wave.electricField(record.distance);
+
+        record.kept = receivers[r].add(record.field, record.length, record.arrival, record.departure);
+
+        uint64_t p = records.size();
+        for (const auto &id: std::set<uint64_t>(faces.begin(), faces.end())) paths[id].push_back(p);
+        launched[l].push_back(p);
+        records.push_back(std::move(record));
+    }
+
+    void reevaluate(Record &record) {
+        std::vector<Wave> chain;
+        chain.reserve(record.origins.size());
+        chain.push_back(launches[record.launch]);
+        for (uint64_t i = 1; i < record.origins.size(); i++) {
+            chain.push_back({record.origins[i], record.directs[i], &chain.back(), &mesh.face(record.faces[i - 1]),
+                             record.interactions[i - 1]});
+        }
+
+        VecC field = chain.back().electricField(record.distance);
+
+        Taps &receiver = receivers[record.receiver];
+        receiver.remove(record.field, record.length, record.arrival, record.departure, record.kept);
+        record.kept = receiver.add(field, record.length, record.arrival, record.departure);
+        record.field = field;
+    }
+
+    // Whether a sequence of interactions begins with the sequence of an event.
+    static bool begins(const std::vector<uint64_t> &faces, const std::vector<nrcc::Interactions> &interactions,
+                       const Event &event) {
+        if (faces.size() < event.faces.size()) return false;
+        for (uint64_t j = 0; j < event.faces.size(); j++) {
+            if (faces[j] != event.faces[j] || interactions[j] != event.interactions[j]) return false;
+        }
+        return true;
+    }
+
+    // Takes back the records and drops the events behind a refraction, keeping the event itself.
+    void prune(const Event &event) {
+        for (const auto &p: launched[event.launch]) {
+            Record &record = records[p];
+            if (!record.live || !begins(record.faces, record.interactions, event)) continue;
+            receivers[record.receiver].remove(record.field, record.length, record.arrival, record.departure,
+                                              record.kept);
+            record.live = false;
+            dead++;
+        }
+        for (const auto &e: branched[event.launch]) {
+            Event &other = events[e];
+            if (&other != &event && other.faces.size() > event.faces.size() &&
+                other.live && begins(other.faces, other.interactions, event)) {
+                other.live = false;
+                dead++;
+            }
+        }
+    }
+
+    // Rebuilds the waves up to the refraction of event e and traces the refracted subtree again.
+    void regrow(const uint64_t &e) {
+        uint64_t l = events[e].launch;
+        std::vector<uint64_t> faces = events[e].faces;
+        std::vector<nrcc::Interactions> interactions = events[e].interactions;
+
+        std::vector<Wave> chain;
+        chain.reserve(faces.size() + 1);
+        chain.push_back(launches[l]);
+        for (uint64_t j = 0; j < faces.size(); j++) {
+            Face &face = mesh.face(faces[j]);
+            if (interactions[j] == nrcc::reflection) chain.push_back(tracer.reflectedWave(chain.back(), face));
+            else chain.push_back(tracer.refractedWave(chain.back(), face));
+        }
+
+        follow(chain.back(), l, faces, interactions, depth - faces.size());
+    }
+
+    // Drops dead records and events, and indexes the live ones again under their new positions.
+    void compact() {
+        std::erase_if(records, [](const Record &record) { return !record.live; });
+        std::erase_if(events, [](const Event &event) { return !event.live; });
+        dead = 0;
+
+        for (auto &list: paths) list.clear();
+        for (auto &list: refractions) list.clear();
+        for (auto &list: launched) list.clear();
+        for (auto &list: branched) list.clear();
+
+        for (uint64_t p = 0; p < records.size(); p++) {
+            const Record &record = records[p];
+            for (const auto &id: std::set<uint64_t>(record.faces.begin(), record.faces.end())) paths[id].push_back(p);
+            launched[record.launch].push_back(p);
+        }
+        for (uint64_t e = 0; e < events.size(); e++) {
+            refractions[events[e].faces.back()].push_back(e);
+            branched[events[e].launch].push_back(e);
+        }
+    }
+};
+
+#endif //NARCCISSUS_EDIT_HPP
@@ -6,6 +6,7 @@
 #include <unordered_set>
 #include "Vec3.hpp"
 #include "Util.hpp"
+#include "Tree.hpp"
 
 template<typename type>
 struct Face {
@@ -15,6 +16,14 @@ struct Face {
     std::array<Vec3, 3> points;
     std::array<Vec3, 2> bounds;
 
+    // Corners in winding order of the convex polygon of a face merged by merge() in Weld.hpp, "sides" of them, or null
+    // for a triangle. points then holds one corner triangle of the polygon, which fixes its plane and normal. The
+    // corners are referenced rather than copied, so that a Face stays small and trivially copyable: whoever builds a
+    // polygon face keeps its outline alive, and Mesh::add() copies the outlines into the group, where they live and
+    // die with the mesh.
+    const Vec3 *outline = nullptr;
+    uint32_t sides = 0;
+
     nrcc::Materials material;
 
     // METHODS
@@ -22,6 +31,21 @@ struct Face {
         return cross(bounds[0], bounds[1]).unit();
     }
 
+    std::vector<Vec3> corners() const {
+        return outline == nullptr ? std::vector<Vec3>{points.begin(), points.end()}
+                                  : std::vector<Vec3>{outline, outline + sides};
+    }
+
+    std::array<Vec3, 2> box() const {
+        Vec3 lower = points[0];
+        Vec3 upper = points[0];
+        for (const auto &point: corners()) {
+            lower = {std::min(lower.x, point.x), std::min(lower.y, point.y), std::min(lower.z, point.z)};
+            upper = {std::max(upper.x, point.x), std::max(upper.y, point.y), std::max(upper.z, point.z)};
+        }
+        return {lower, upper};
+    }
+
     // CONSTRUCTORS
     Face(const std::array<Vec3, 3> &ps) :
             points(ps),
@@ -43,17 +67,87 @@ struct Face {
             bounds{q - p, r - p},
             material(material) {}
 
+    // Convex polygon. The corner triangle of largest area spans the plane, so collinear corners are harmless. The face
+    // refers to "outline", which must outlive it and keep its size.
+    Face(const std::vector<Vec3> &outline, const nrcc::Materials material) :
+            outline(outline.data()),
+            sides(outline.size()),
+            material(material) {
+        uint64_t best = 1;
+        for (uint64_t i = 1; i + 1 < outline.size(); i++) {
+            Vec3 c = cross(outline[i] - outline[0], outline[i + 1] - outline[0]);
+            Vec3 b = cross(outline[best] - outline[0], outline[best + 1] - outline[0]);
+            if (c.norm() > b.norm()) best = i;
+        }
+        points = {outline[0], outline[best], outline[best + 1]};
+        bounds = {points[1] - points[0], points[2] - points[0]};
+    }
+
     std::complex<type> refractiveIndex(const type &frequency) const {
-        type n = nrcc::permittivity[material][0] * std::pow(frequency, nrcc::permittivity[material][1]);
+        return nrcc::refractiveIndex(material, frequency);
+    }
+};
+
+namespace nrcc {
+    // Distance along a ray to the plane of a convex polygon face, or -1 if the ray misses the polygon.
+    template<typename T>
+    T polygonDistance(const Vec3<T> &origin, const Vec3<T> &direct, const Face<T> &face) {
+        Vec3<T> n = cross(face.bounds[0], face.bounds[1]);
+
+        T det = dot(direct, n);
 
-        type c = nrcc::conductivity[material][0] * std::pow(frequency, nrcc::conductivity[material][1]);
+        if (std::fabs(det) < nrcc::epsilon * n.norm()) return -1.0;
 
-        type k = 17.98 * c / frequency;
+        T t = dot(face.points[0] - origin, n) / det;
 
-        return {n, k};
+        Vec3<T> p = origin + direct * t;
+
+        for (uint64_t i = 0; i < face.sides; i++) {
+            const Vec3<T> &a = face.outline[i];
+            const Vec3<T> &b = face.outline[(i + 1) % face.sides];
+            if (dot(cross(b - a, p - a), n) < 0) return -1.0;
+        }
+
+        return t;
     }
-    // https://www.itu.int/dms_pubrec/itu-r/rec/p/R-REC-P.2040-1-201507-S!!PDF-E.pdf
-};
+
+    // Moller-Trumbore distance along a ray to a face, or -1 if the ray misses it.
+    template<typename T>
+    T intersectionDistance(const Vec3<T> &origin, const Vec3<T> &direct, const Face<T> &face) {
+        if (face.outline != nullptr) return polygonDistance(origin, direct, face);
+
+        Vec3<T> p_vec = cross(direct, face.bounds[1]);
+
+        T det = dot(face.bounds[0], p_vec);
+
+        if (std::fabs(det) < nrcc::epsilon) return -1.0;
+
+        Vec3<T> t_vec = origin - face.points[0];
+
+        T u = dot(t_vec, p_vec) * (1 / det);
+
+        if (u < 0 || u > 1) return -1.0;
+
+        Vec3<T> q_vec = cross(t_vec, face.bounds[0]);
+
+        T v = dot(direct, q_vec) * (1 / det);
+
+        if (v < 0 || u + v > 1) return -1.0;
+
+        return dot(face.bounds[1], q_vec) * (1 / det);
+    }
+}
+
+// Box tree over a face set, indices refer to positions in faces.
+template<typename type>
+Tree<type> tree(const std::vector<Face<type>> &faces) {
+    std::vector<std::array<Vec3<type>, 2>> boxes;
+    for (const auto &face: faces) boxes.push_back(face.box());
+
+    Tree<type> t;
+    t.build(boxes);
+    return t;
+}
 
 struct hash {
     std::size_t operator()(const std::array<uint64_t, 4> &face) const {
@@ -0,0 +1,113 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Fresnel coefficient tables. At a fixed frequency the coefficients of an interaction depend only on the two materials
+// and the angle of incidence, so each pair is sampled once over cos(theta_i) in [0, 1] and interactions interpolate
+// linearly between samples instead of evaluating complex square roots and divisions.
+//
+// A table starts at 64 samples and doubles until no coefficient between two samples is off from the exact value by more
+// than "tolerance", or until "limit" samples. Intervals still above the tolerance then, around a critical angle or the
+// steep grazing edge of a lossy material, are flagged "unresolved" and evaluated exactly, so every lookup is within the
+// tolerance. "error" is the largest interpolation error of the other intervals.
+//
+// table() builds tables lazily, the first time a material pair meets at a frequency, so only pairs present in the scene
+// are ever built. Tables are kept per thread, so lookups take no lock. Changing tolerance or limit affects tables built
+// afterwards; clear() drops the tables of the calling thread.
+
+#ifndef NARCCISSUS_FRES_HPP
+#define NARCCISSUS_FRES_HPP
+
+#include <memory>
+#include <tuple>
+#include "Util.hpp"
+
+template<typename type>
+class Fres {
+    using cmpx = std::complex<type>;
+
+public:
+    // Perpendicular and parallel reflection, then perpendicular and parallel transmission. The parallel coefficients
+    // take the field along s x k for each ray, with s perpendicular to the plane of incidence.
+    using Coefficients = std::array<cmpx, 4>;
+
+    // VARIABLES
+    std::vector<Coefficients> samples;
+    std::vector<bool> unresolved;
+    type error = 0;
+
+    static inline type tolerance = 1e-4;
+    static inline uint64_t limit = 1 << 12;
+
+    // METHODS
+    Coefficients operator()(const type &cos_i) const {
+        type x = std::clamp(cos_i, type(0), type(1)) * (samples.size() - 1);
+        uint64_t i = std::min<uint64_t>(x, samples.size() - 2);
+        if (unresolved[i]) return exact(n1, n2, cos_i);
+
+        type f = x - i;
+
+        Coefficients c;
+        for (int k = 0; k < 4; k++) c[k] = samples[i][k] + (samples[i + 1][k] - samples[i][k]) * f;
+        return c;
+    }
+
+    static Coefficients exact(const cmpx &n1, const cmpx &n2, const type &cos_i) {
+        cmpx sin_i = std::sqrt(1 - cos_i * cos_i);
+
+        cmpx sin_t = n1 / n2 * sin_i;
+        cmpx cos_t = std::sqrt(cmpx(1.0) - sin_t * sin_t);
+
+        return {(n1 * cos_i - n2 * cos_t) / (n1 * cos_i + n2 * cos_t),
+                (n2 * cos_i - n1 * cos_t) / (n2 * cos_i + n1 * cos_t),
+                (cmpx(2) * n1 * cos_i) / (n1 * cos_i + n2 * cos_t),
+                (cmpx(2) * n1 * cos_i) / (n1 * cos_t + n2 * cos_i)};
+    }
+
+    // Table for a wave in material "from" meeting material "to".
+    static const Fres &table(const nrcc::Materials &from, const nrcc::Materials &to, const type &frequency) {
+        auto &table = tables[{from, to, frequency}];
+        if (!table) table = std::make_unique<Fres>(nrcc::refractiveIndex(from, frequency),
+                                                   nrcc::refractiveIndex(to, frequency));
+        return *table;
+    }
+
+    static void clear() {
+        tables.clear();
+    }
+
+    static uint64_t size() {
+        return tables.size();
+    }
+
+    // CONSTRUCTORS
+    Fres(const cmpx &n1, const cmpx &n2) : n1(n1), n2(n2) {
+        for (uint64_t n = 64;; n *= 2) {
+            samples.resize(n + 1);
+            for (uint64_t i = 0; i <= n; i++) samples[i] = exact(n1, n2, type(i) / n);
+
+            error = 0;
+            unresolved.assign(n, false);
+            bool resolved = true;
+            for (uint64_t i = 0; i < n; i++) {
+                Coefficients midpoint = exact(n1, n2, (i + 0.5) / n);
+
+                type e = 0;
+                for (int k = 0; k < 4; k++) {
+                    e = std::max(e, std::abs(midpoint[k] - (samples[i][k] + samples[i + 1][k]) * type(0.5)));
+                }
+                if (e > tolerance) unresolved[i] = true;
+                else error = std::max(error, e);
+                resolved = resolved && !unresolved[i];
+            }
+            if (resolved || n * 2 > limit) break;
+        }
+    }
+
+private:
+    cmpx n1;
+    cmpx n2;
+
+    static inline thread_local std::map<std::tuple<nrcc::Materials, nrcc::Materials, type>, std::unique_ptr<Fres>>
+            tables;
+};
+
+#endif //NARCCISSUS_FRES_HPP
@@ -0,0 +1,226 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Tabulated antenna patterns. The far field is given as complex theta and phi components on a regular grid of
+// "thetas" rows from 0 to pi (both poles included) by "phis" columns from 0 to 2 pi (wrapping), in the antenna frame:
+// theta is measured from "axis" and phi from "reference" towards axis x reference. Power gain is the squared magnitude
+// of the field. Lookups interpolate bilinearly between the four surrounding grid points, so they cost the same for any
+// table size.
+//
+// For importance sampled launches every grid cell is weighted by its mean gain times its solid angle. Directions are
+// drawn cell by cell from that distribution and uniformly within a cell, and pdf() gives their density, so a ray's
+// power can be weighted by gain / pdf to stay unbiased.
+//
+// A grid with fewer than two theta rows, no phi columns or a field count other than thetas * phis is rejected, as is a
+// file whose angles are not that grid in order. A rejected pattern is left empty and radiates nothing.
+
+#ifndef NARCCISSUS_GAIN_HPP
+#define NARCCISSUS_GAIN_HPP
+
+#include <fstream>
+#include <sstream>
+#include "Vec3.hpp"
+#include "Util.hpp"
+
+template<typename type>
+class Gain {
+    using cmpx = std::complex<type>;
+    using VecC = Vec3<cmpx>;
+    using Vec3 = Vec3<type>;
+    using Field = std::array<cmpx, 2>;
+
+public:
+    // VARIABLES
+    uint64_t thetas;
+    uint64_t phis;
+    std::vector<Field> fields;
+
+    Vec3 axis = {0, 0, 1};
+    Vec3 reference = {1, 0, 0};
+
+    // METHODS
+    bool empty() const {
+        return thetas == 0;
+    }
+
+    type gain(const Vec3 &direct) const {
+        Field f = field(direct);
+        return std::norm(f[0]) + std::norm(f[1]);
+    }
+
+    // Unit field direction of a direction, in global coordinates.
+    VecC polarization(const Vec3 &direct) const {
+        auto [theta, phi] = angles(direct);
+        Field f = field(direct);
+
+        Vec3 x = reference;
+        Vec3 y = cross(axis, reference);
+        Vec3 t_hat = x * (std::cos(theta) * std::cos(phi)) + y * (std::cos(theta) * std::sin(phi)) - axis * std::sin(theta);
+        Vec3 p_hat = y * std::cos(phi) - x * std::sin(phi);
+
+        VecC e = t_hat.cmpx() * f[0] + p_hat.cmpx() * f[1];
+        type n = std::sqrt(std::norm(e.x) + std::norm(e.y) + std::norm(e.z));
+        return n > 0 ? e / cmpx(n) : e;
+    }
+
+    // Density of sample() per steradian.
+    type pdf(const Vec3 &direct) const {
+        if (empty()) return 0;
+
+        auto [theta, phi] = angles(direct);
+        uint64_t i = std::min<uint64_t>(theta / nrcc::pi * (thetas - 1), thetas - 2);
+        uint64_t j = static_cast<uint64_t>(phi / (2 * nrcc::pi) * phis) % phis;
+        uint64_t c = i * phis + j;
+
+        type w = cdf[c + 1] - cdf[c];
+        return w / (cdf.back() * solid(i));
+    }
+
+    Vec3 sample(Rand &generator) const {
+        if (empty()) return axis;
+
+        type u = generator.uniform() * cdf.back();
+        uint64_t c = std::upper_bound(cdf.begin() + 1, cdf.end(), u) - cdf.begin() - 1;
+        c = std::min<uint64_t>(c, cdf.size() - 2);
+
+        uint64_t i = c / phis;
+        uint64_t j = c % phis;
+        type z0 = std::cos(nrcc::pi * i / (thetas - 1));
+        type z1 = std::cos(nrcc::pi * (i + 1) / (thetas - 1));
+        type z = z0 + (z1 - z0) * generator.uniform();
+        type phi = 2 * nrcc::pi * (j + generator.uniform()) / phis;
+        type s = std::sqrt(std::max(type(0), 1 - z * z));
+
+        Vec3 y = cross(axis, reference);
+        return reference * (s * std::cos(phi)) + y * (s * std::sin(phi)) + axis * z;
+    }
+
+    // Reads "theta phi re(E_theta) im(E_theta) re(E_phi) im(E_phi)" lines, angles in degrees, theta major.
+    static Gain read(std::ifstream pattern) {
+        if (!pattern) {
+            std::cerr << "Error: Could not open file\n";
+            return {};
+        }
+
+        std::vector<Field> fs;
+        std::vector<std::array<type, 2>> as;
+        std::vector<type> ts;
+        std::string line;
+        while (std::getline(pattern, line)) {
+            if (line.empty() || line[0] == '#') continue;
+
+            std::istringstream ss(line);
+            type theta, phi, a, b, c, d;
+            if (!(ss >> theta >> phi >> a >> b >> c >> d)) {
+                std::cerr << "Error: Malformed pattern line \"" << line << "\"\n";
+                return {};
+            }
+            if (ts.empty() || ts.back() != theta) ts.push_back(theta);
+            as.push_back({theta, phi});
+            fs.push_back({cmpx{a, b}, cmpx{c, d}});
+        }
+
+        uint64_t thetas = ts.size();
+        uint64_t phis = fs.size() / std::max<uint64_t>(1, thetas);
+        if (thetas < 2 || phis < 1 || fs.size() != thetas * phis) {
+            std::cerr << "Error: Pattern has " << fs.size() << " points in " << thetas << " theta rows\n";
+            return {};
+        }
+        for (uint64_t k = 0; k < as.size(); k++) {
+            type theta = type(180) * (k / phis) / (thetas - 1);
+            type phi = type(360) * (k % phis) / phis;
+            if (std::abs(as[k][0] - theta) > 1e-6 || std::abs(as[k][1] - phi) > 1e-6) {
+                std::cerr << "Error: Pattern point " << as[k][0] << ", " << as[k][1] << " should be " << theta << ", "
+                          << phi << "\n";
+                return {};
+            }
+        }
+        return {thetas, phis, fs};
+    }
+
+    // Sector antenna of the 3GPP TR 38.901 model, vertically polarized: 12 dB per half power beamwidth squared in
+    // each plane, floored at the front to back ratio. Boresight is phi = 0 on the horizon.
+    static Gain sector(const type &azimuth_width, const type &elevation_width, const type &front_to_back,
+                       const type &peak, const uint64_t &thetas = 181, const uint64_t &phis = 360) {
+        std::vector<Field> fs;
+        for (uint64_t i = 0; i < thetas; i++) {
+            for (uint64_t j = 0; j < phis; j++) {
+                type theta = nrcc::pi * i / (thetas - 1);
+                type phi = 2 * nrcc::pi * j / phis;
+                if (phi > nrcc::pi) phi -= 2 * nrcc::pi;
+
+                type horizontal = std::min(12 * std::pow(phi / azimuth_width, 2), front_to_back);
+                type vertical = std::min(12 * std::pow((theta - nrcc::pi / 2) / elevation_width, 2), front_to_back);
+                type db = peak - std::min(horizontal + vertical, front_to_back);
+
+                fs.push_back({cmpx{std::pow(type(10), db / 20), 0}, cmpx{0, 0}});
+            }
+        }
+        return {thetas, phis, fs};
+    }
+
+    // CONSTRUCTORS
+    Gain(const uint64_t &thetas, const uint64_t &phis, const std::vector<Field> &fields) :
+            thetas(thetas), phis(phis), fields(fields) {
+        if (thetas < 2 || phis < 1 || fields.size() != thetas * phis) {
+            std::cerr << "Error: Pattern of " << thetas << " by " << phis << " needs at least 2 by 1 and that many "
+                      << "fields, not " << fields.size() << "\n";
+            this->thetas = 0;
+            this->phis = 0;
+            this->fields.clear();
+            return;
+        }
+
+        cdf = {0};
+        for (uint64_t i = 0; i + 1 < thetas; i++) {
+            for (uint64_t j = 0; j < phis; j++) {
+                type g = 0;
+                for (const auto &[a, b]: {std::pair{i, j}, {i + 1, j}, {i, (j + 1) % phis}, {i + 1, (j + 1) % phis}}) {
+                    g += std::norm(fields[a * phis + b][0]) + std::norm(fields[a * phis + b][1]);
+                }
+                cdf.push_back(cdf.back() + g / 4 * solid(i));
+            }
+        }
+    }
+
+private:
+    std::vector<type> cdf;
+
+    // Empty pattern.
+    Gain() : thetas(0), phis(0) {}
+
+    std::array<type, 2> angles(const Vec3 &direct) const {
+        Vec3 d = direct.unit();
+        type theta = std::acos(std::clamp(dot(d, axis), type(-1), type(1)));
+        type phi = std::atan2(dot(d, cross(axis, reference)), dot(d, reference));
+        return {theta, phi < 0 ? phi + 2 * nrcc::pi : phi};
+    }
+
+    Field field(const Vec3 &direct) const {
+        if (empty()) return {0, 0};
+
+        auto [theta, phi] = angles(direct);
+
+        type u = theta / nrcc::pi * (thetas - 1);
+        type v = phi / (2 * nrcc::pi) * phis;
+        uint64_t i = std::min<uint64_t>(u, thetas - 2);
+        uint64_t j = static_cast<uint64_t>(v) % phis;
+        uint64_t k = (j + 1) % phis;
+        type a = u - i;
+        type b = v - std::floor(v);
+
+        Field f;
+        for (int c = 0; c < 2; c++) {
+            f[c] = (fields[i * phis + j][c] * (1 - b) + fields[i * phis + k][c] * b) * (1 - a) +
+                   (fields[(i + 1) * phis + j][c] * (1 - b) + fields[(i + 1) * phis + k][c] * b) * a;
+        }
+        return f;
+    }
+
+    // Solid angle of a cell in theta row i.
+    type solid(const uint64_t &i) const {
+        return (std::cos(nrcc::pi * i / (thetas - 1)) - std::cos(nrcc::pi * (i + 1) / (thetas - 1))) * 2 * nrcc::pi /
+               phis;
+    }
+};
+
+#endif //NARCCISSUS_GAIN_HPP
@@ -0,0 +1,205 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Instanced scene. Repeated geometry such as furniture, lamp posts or building blocks is stored once as a prototype
+// Mesh, with its own trees, and placed any number of times as instances. An instance is an affine transform, a linear
+// part and an offset, and optionally a material that overrides the prototype's. A top level tree over the world boxes
+// of the instances is the first of two levels: a ray entering an instance box is carried into prototype space by the
+// inverse transform and traced there with the prototype's trees. The direction is not renormalized, so distances
+// along the ray are the same in both spaces. Memory and build time grow with the unique prototypes, while an instance
+// costs its transform and a box. The top level tree is built by build(), once every instance is placed: instances
+// placed after the last build() are not traced. A linear part that is singular has no inverse and is rejected.
+//
+// Nrcc::closest accepts an Inst as a scene. The tracer needs world faces for normals and materials, so a face is made
+// in world space the first time it is hit and kept, and its pointer stays valid like a Mesh face's until clear(). Only
+// faces actually hit are ever made.
+
+#ifndef NARCCISSUS_INST_HPP
+#define NARCCISSUS_INST_HPP
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include "Mesh.hpp"
+
+template<typename type>
+class Inst {
+    using Vec3 = Vec3<type>;
+    using Face = Face<type>;
+    using Tree = Tree<type>;
+    using Mesh = Mesh<type>;
+    using Box = std::array<Vec3, 2>;
+
+public:
+    // World point = linear * prototype point + offset, with the linear part stored by rows.
+    struct Instance {
+        uint64_t prototype;
+        std::array<Vec3, 3> linear;
+        Vec3 offset;
+        std::array<Vec3, 3> inverse;
+        std::optional<nrcc::Materials> material;
+    };
+
+    struct Hit {
+        type distance;
+        uint64_t instance;
+        uint64_t group;
+        uint64_t index;
+    };
+
+    static constexpr uint64_t none = UINT64_MAX;
+
+    // VARIABLES
+    std::vector<Mesh> prototypes;
+    std::vector<Instance> instances;
+    Tree top;
+
+    // METHODS
+    uint64_t add(const std::vector<Face> &faces) {
+        prototypes.emplace_back(faces);
+        return prototypes.size() - 1;
+    }
+
+    // Index of the new instance, or "none" if the linear part is singular.
+    uint64_t place(const uint64_t &prototype, const std::array<Vec3, 3> &linear, const Vec3 &offset,
+                   const std::optional<nrcc::Materials> &material = std::nullopt) {
+        const auto &r = linear;
+        type det = dot(r[0], cross(r[1], r[2]));
+        if (!(std::fabs(det) > nrcc::epsilon * r[0].norm() * r[1].norm() * r[2].norm())) {
+            std::cerr << "Error: Instance transform is singular\n";
+            return none;
+        }
+
+        Vec3 c0 = cross(r[1], r[2]) / det;
+        Vec3 c1 = cross(r[2], r[0]) / det;
+        Vec3 c2 = cross(r[0], r[1]) / det;
+
+        instances.push_back({prototype, linear, offset, {Vec3{c0.x, c1.x, c2.x}, Vec3{c0.y, c1.y, c2.y},
+                                                          Vec3{c0.z, c1.z, c2.z}}, material});
+        boxes.push_back(box(instances.back()));
+        return instances.size() - 1;
+    }
+
+    // Builds the top level tree over the instances placed so far.
+    void build() {
+        top.leaf_size = 1;
+        top.build(boxes);
+    }
+
+    // Rotation by "angle" radians about the y axis, scaled uniformly, the usual placement of props on the ground.
+    static std::array<Vec3, 3> turn(const type &angle, const type &scale = 1) {
+        type c = std::cos(angle) * scale;
+        type s = std::sin(angle) * scale;
+        return {Vec3{c, 0, s}, Vec3{0, scale, 0}, Vec3{-s, 0, c}};
+    }
+
+    static Vec3 apply(const std::array<Vec3, 3> &m, const Vec3 &v) {
+        return {dot(m[0], v), dot(m[1], v), dot(m[2], v)};
+    }
+
+    // Closest face hit by a ray before limit. A miss has an infinite distance.
+    Hit intersect(const Vec3 &origin, const Vec3 &direct, const type &limit = nrcc::infinity) const {
+        Hit hit = {nrcc::infinity, 0, 0, 0};
+
+        top.traverse(origin, direct, limit, [&](const uint64_t &i, type &top_limit) {
+            const Instance &instance = instances[i];
+            Vec3 local_origin = apply(instance.inverse, origin - instance.offset);
+            Vec3 local_direct = apply(instance.inverse, direct);
+
+            auto local = prototypes[instance.prototype].intersect(local_origin, local_direct, top_limit);
+            if (local.distance < top_limit) {
+                hit = {local.distance, i, local.group, local.index};
+                top_limit = local.distance;
+            }
+            return false;
+        });
+        return hit;
+    }
+
+    bool occluded(const Vec3 &origin, const Vec3 &target) const {
+        bool blocked = false;
+        top.traverse(origin, (target - origin).unit(), range(origin, target), [&](const uint64_t &i, type &) {
+            const Instance &instance = instances[i];
+            Vec3 local_origin = apply(instance.inverse, origin - instance.offset);
+            Vec3 local_target = apply(instance.inverse, target - instance.offset);
+            blocked = prototypes[instance.prototype].occluded(local_origin, local_target);
+            return blocked;
+        });
+        return blocked;
+    }
+
+    // The hit face in world space, made on first use.
+    Face &face(const Hit &hit) {
+        std::lock_guard lock(mutex);
+        std::array<uint64_t, 3> key = {hit.instance, hit.group, hit.index};
+        auto found = faces.find(key);
+        if (found != faces.end()) return found->second;
+
+        const Instance &instance = instances[hit.instance];
+        const Face &face = prototypes[instance.prototype].groups[hit.group].faces[hit.index];
+        nrcc::Materials material = instance.material.value_or(face.material);
+
+        std::vector<Vec3> corners = face.corners();
+        for (auto &corner: corners) corner = apply(instance.linear, corner) + instance.offset;
+
+        Face world = face.outline == nullptr ? Face(corners[0], corners[1], corners[2], material)
+                                             : Face(outlines[key] = corners, material);
+        return faces.emplace(key, world).first->second;
+    }
+
+    // Faces in world space, every instance expanded, as a scene without instancing would hold them. The corners of
+    // polygon faces are appended to "polygons", which must last until the faces are added to a Mesh.
+    std::vector<Face> expand(std::vector<std::vector<Vec3>> &polygons) const {
+        std::vector<Face> expanded;
+        for (const auto &instance: instances) {
+            for (const auto &group: prototypes[instance.prototype].groups) {
+                for (const auto &face: group.faces) {
+                    std::vector<Vec3> corners = face.corners();
+                    for (auto &corner: corners) corner = apply(instance.linear, corner) + instance.offset;
+
+                    nrcc::Materials material = instance.material.value_or(face.material);
+                    if (face.outline == nullptr) expanded.push_back({corners[0], corners[1], corners[2], material});
+                    else expanded.push_back({polygons.emplace_back(std::move(corners)), material});
+                }
+            }
+        }
+        return expanded;
+    }
+
+    // Drops the world faces made so far, which invalidates their pointers.
+    void clear() {
+        std::lock_guard lock(mutex);
+        faces.clear();
+        outlines.clear();
+    }
+
+    uint64_t made() const {
+        return faces.size();
+    }
+
+    // CONSTRUCTORS
+    Inst() = default;
+
+private:
+    std::vector<Box> boxes;
+    std::map<std::array<uint64_t, 3>, Face> faces;
+    std::map<std::array<uint64_t, 3>, std::vector<Vec3>> outlines;
+    std::mutex mutex;
+
+    // World box of an instance, from the eight transformed corners of its prototype box.
+    Box box(const Instance &instance) const {
+        const Mesh &mesh = prototypes[instance.prototype];
+        if (mesh.top.empty()) return {instance.offset, instance.offset};
+
+        const Box &local = mesh.top.nodes[0].box;
+        Box world = {apply(instance.linear, local[0]) + instance.offset,
+                     apply(instance.linear, local[0]) + instance.offset};
+        for (int c = 1; c < 8; c++) {
+            Vec3 corner = {local[c & 1].x, local[(c >> 1) & 1].y, local[(c >> 2) & 1].z};
+            Vec3 p = apply(instance.linear, corner) + instance.offset;
+            world = Tree::merge(world, {p, p});
+        }
+        return world;
+    }
+};
+
+#endif //NARCCISSUS_INST_HPP
@@ -0,0 +1,312 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Sharded runs. A job traces a set of transmitters into a set of receiver accumulators, split into "shards" either by
+// launch direction range (every transmitter, a slice of its rays) or by transmitter (all rays of a slice of the
+// transmitters). Each shard runs in its own worker process and writes its partial result to its own file:
+//
+//   magic, version, configuration, shard, shards, launched waves, receiver count, receivers..., checksum
+//
+// Files are written under a temporary name and renamed once complete, and carry an FNV-1a checksum, so a shard file
+// either exists whole or not at all. "configuration" hashes everything that decides a shard's result, so files left
+// by a job with other transmitters, receivers, settings or mesh are not valid. run() only starts shards without a
+// valid file, so a crashed or killed job is resumed by running it again and loses at most the shards that were in
+// flight. merge() combines the partials in shard order, which makes the result independent of which worker finished
+// first.
+//
+// Worker processes are forked on POSIX systems. Elsewhere the shards run one after another in the calling process.
+
+#ifndef NARCCISSUS_JOBS_HPP
+#define NARCCISSUS_JOBS_HPP
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include "Mesh.hpp"
+#include "Nrcc.hpp"
+#include "Pole.hpp"
+#include "Taps.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#include <sys/wait.h>
+#define NARCCISSUS_FORK
+#endif
+
+template<typename type>
+class Jobs {
+    using Wave = Wave<type>;
+    using Pole = Pole<type>;
+    using Taps = Taps<type>;
+    using Mesh = Mesh<type>;
+
+public:
+    enum Split {
+        by_direction,
+        by_transmitter,
+    };
+
+    // VARIABLES
+    Mesh &mesh;
+    std::vector<Pole> transmitters;
+    std::vector<Taps> receivers;
+
+    std::string directory;
+    uint64_t shards;
+    Split split = by_direction;
+
+    type power = 1;
+    type scaling = 2;
+    uint64_t accuracy = 4;
+    uint8_t depth = 2;
+
+    uint64_t launched = 0;
+
+    static constexpr uint32_t magic = 0x4E524343;
+    static constexpr uint32_t version = 4;
+
+    // METHODS
+    std::string file(const uint64_t &shard) const {
+        return directory + "/shard_" + std::to_string(shard) + ".bin";
+    }
+
+    // True if the shard has a complete, uncorrupted partial of this job on disk.
+    bool done(const uint64_t &shard) const {
+        return done(shard, configuration());
+    }
+
+    // FNV-1a hash of the split, the launch settings, the transmitters, the receiver configurations (not their
+    // contents) and the mesh faces.
+    uint64_t configuration() const {
+        std::ostringstream body;
+        auto put = [&](const auto &value) { body.write(reinterpret_cast<const char *>(&value), sizeof(value)); };
+        auto point = [&](const Vec3<type> &p) {
+            put(p.x);
+            put(p.y);
+            put(p.z);
+        };
+
+        put(shards);
+        put(static_cast<uint32_t>(split));
+        put(power);
+        put(scaling);
+        put(accuracy);
+        put(depth);
+
+        put(static_cast<uint64_t>(transmitters.size()));
+        for (const auto &transmitter: transmitters) {
+            point(transmitter.coordinates);
+            point(transmitter.orientation);
+            put(transmitter.frequency);
+            put(transmitter.length);
+            put(transmitter.pattern != nullptr);
+            if (transmitter.pattern == nullptr) continue;
+
+            put(transmitter.pattern->thetas);
+            put(transmitter.pattern->phis);
+            for (const auto &field: transmitter.pattern->fields) put(field);
+            point(transmitter.pattern->axis);
+            point(transmitter.pattern->reference);
+        }
+
+        put(static_cast<uint64_t>(receivers.size()));
+        for (const auto &receiver: receivers) {
+            point(receiver.pole.coordinates);
+            point(receiver.pole.orientation);
+            put(receiver.pole.frequency);
+            put(receiver.pole.length);
+            put(receiver.resolution);
+            put(receiver.bins);
+            put(receiver.sectors);
+            put(receiver.capacity);
+        }
+
+        for (const auto &group: mesh.groups) {
+            put(static_cast<uint64_t>(group.faces.size()));
+            for (const auto &face: group.faces) {
+                for (const auto &corner: face.corners()) point(corner);
+                put(face.material);
+            }
+        }
+
+        return checksum(body.str());
+    }
+
+    // Traces one shard in this process and writes its partial.
+    void work(const uint64_t &shard) {
+        work(shard, nrcc::icosphere<type>(accuracy));
+    }
+
+    // Runs every shard that is not done yet on at most "workers" processes at a time.
+    void run(const uint64_t &workers) {
+        // Built once here, so forked workers share the directions instead of each building its own.
+        std::vector<Vec3<type>> directions = nrcc::icosphere<type>(accuracy);
+        uint64_t hash = configuration();
+        std::vector<uint64_t> pending;
+        for (uint64_t shard = 0; shard < shards; shard++) {
+            if (!done(shard, hash)) pending.push_back(shard);
+        }
+
+#ifdef NARCCISSUS_FORK
+        uint64_t active = 0;
+        for (const auto &shard: pending) {
+            if (active == workers) {
+                wait(nullptr);
+                active--;
+            }
+
+            pid_t pid = fork();
+            if (pid == 0) {
+                work(shard, directions);
+                _exit(0);
+            }
+            if (pid > 0) active++;
+            else work(shard, directions);
+        }
+        while (active-- > 0) wait(nullptr);
+#else
+        for (const auto &shard: pending) work(shard, directions);
+#endif
+    }
+
+    // Combines every shard into "receivers". Returns false, leaving receivers untouched, if a shard is missing or
+    // belongs to another job.
+    bool merge() {
+        std::vector<Taps> merged = receivers;
+        for (auto &receiver: merged) receiver.clear();
+
+        uint64_t hash = configuration();
+        uint64_t total = 0;
+        for (uint64_t shard = 0; shard < shards; shard++) {
+            std::vector<Taps> partial = receivers;
+            uint64_t waves;
+            if (!load(shard, partial, waves, hash)) return false;
+
+            for (uint64_t r = 0; r < merged.size(); r++) merged[r].merge(partial[r]);
+            total += waves;
+        }
+
+        receivers = merged;
+        launched = total;
+        return true;
+    }
+
+    // CONSTRUCTORS
+    Jobs(Mesh &mesh, const std::vector<Pole> &transmitters, const std::vector<Taps> &receivers,
+         const std::string &directory, const uint64_t &shards) :
+            mesh(mesh), transmitters(transmitters), receivers(receivers), directory(directory), shards(shards) {}
+
+private:
+    // Contiguous slice [first, last) of n rays or transmitters, so a shard's stay neighbours.
+    std::pair<uint64_t, uint64_t> slice(const uint64_t &n, const uint64_t &shard) const {
+        return {(shard * n + shards - 1) / shards, ((shard + 1) * n + shards - 1) / shards};
+    }
+
+    // Traces the shard's slice along the given launch directions. Only the waves of the slice are built, with the
+    // powers they have in a full launch.
+    void work(const uint64_t &shard, const std::vector<Vec3<type>> &directions) {
+        std::vector<Taps> partial = receivers;
+        for (auto &receiver: partial) receiver.clear();
+
+        Nrcc<type> tracer;
+        uint64_t waves = 0;
+
+        auto [first, last] = split == by_transmitter ? slice(transmitters.size(), shard) :
+                             std::pair<uint64_t, uint64_t>{0, transmitters.size()};
+        auto [begin, end] = split == by_direction ? slice(directions.size(), shard) :
+                            std::pair<uint64_t, uint64_t>{0, directions.size()};
+
+        for (uint64_t t = first; t < last; t++) {
+            std::vector<Wave> transmitted = transmitters[t].transmit(power, 0, scaling, directions, begin, end);
+            for (auto &wave: transmitted) {
+                tracer.trace(wave, mesh, partial, depth);
+                waves++;
+            }
+        }
+
+        store(shard, partial, waves, configuration());
+    }
+
+    static uint64_t checksum(const std::string &bytes) {
+        uint64_t h = 14695981039346656037ull;
+        for (const auto &c: bytes) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 1099511628211ull;
+        }
+        return h;
+    }
+
+    bool done(const uint64_t &shard, const uint64_t &hash) const {
+        std::vector<Taps> partial = receivers;
+        uint64_t waves;
+        return load(shard, partial, waves, hash);
+    }
+
+    void store(const uint64_t &shard, const std::vector<Taps> &partial, const uint64_t &waves,
+               const uint64_t &hash) const {
+        std::ostringstream body;
+        auto put = [&](const auto &value) { body.write(reinterpret_cast<const char *>(&value), sizeof(value)); };
+
+        put(magic);
+        put(version);
+        put(hash);
+        put(shard);
+        put(shards);
+        put(waves);
+        put(static_cast<uint64_t>(partial.size()));
+        for (const auto &receiver: partial) receiver.write(body);
+
+        std::string bytes = body.str();
+        uint64_t sum = checksum(bytes);
+
+        std::string temporary = file(shard) + ".tmp";
+        std::ofstream out(temporary, std::ofstream::binary);
+        out.write(bytes.data(), bytes.size());
+        out.write(reinterpret_cast<const char *>(&sum), sizeof(sum));
+        out.close();
+
+        if (out) std::rename(temporary.c_str(), file(shard).c_str());
+        else std::remove(temporary.c_str());
+    }
+
+    bool load(const uint64_t &shard, std::vector<Taps> &partial, uint64_t &waves, const uint64_t &hash) const {
+        std::ifstream in(file(shard), std::ifstream::binary | std::ifstream::ate);
+        if (!in) return false;
+
+        std::string bytes(static_cast<uint64_t>(in.tellg()), '\0');
+        in.seekg(0);
+        in.read(bytes.data(), bytes.size());
+        if (bytes.size() < sizeof(uint64_t)) return false;
+
+        uint64_t sum;
+        std::copy(bytes.end() - sizeof(sum), bytes.end(), reinterpret_cast<char *>(&sum));
+        bytes.resize(bytes.size() - sizeof(sum));
+        if (checksum(bytes) != sum) return false;
+
+        std::istringstream body(bytes);
+        auto get = [&](auto &value) { body.read(reinterpret_cast<char *>(&value), sizeof(value)); };
+
+        uint32_t m;
+        uint32_t v;
+        uint64_t h;
+        uint64_t s;
+        uint64_t n;
+        uint64_t count;
+        get(m);
+        get(v);
+        get(h);
+        get(s);
+        get(n);
+        get(waves);
+        get(count);
+        if (m != magic || v != version || h != hash || s != shard || n != shards || count != partial.size()) {
+            return false;
+        }
+
+        for (auto &receiver: partial) {
+            if (!receiver.read(body)) return false;
+        }
+        return true;
+    }
+};
+
+#endif //NARCCISSUS_JOBS_HPP
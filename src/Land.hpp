@@ -0,0 +1,262 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Terrain as a heightfield. Elevations are sampled on a regular grid in x and z, and every cell between four samples
+// has one material, such as ground, desert or swamp, and is split along its diagonal into two triangles. Only the
+// elevations and a byte per cell are stored, so a large elevation model fits where its triangles would not.
+//
+// Rays are intersected against a min / max pyramid of the cells instead of a tree of triangles. Level 0 holds the
+// lowest and highest elevation of each cell, and every level above those of 2 by 2 blocks of the level below. A block
+// is skipped when the height of the ray over its footprint stays above its maximum or below its minimum; otherwise its
+// four children are visited nearest corner first, as the signs of the ray direction order them, down to the two
+// triangles of a cell. Those are intersected straight from the four heights as planes over the cell, without making
+// faces. Children the ray enters beyond the closest hit so far are skipped.
+//
+// Buildings and other faces stand on the terrain in "mesh", and intersect() returns the closer of the two, so a Land
+// is a whole rural scene for Nrcc::closest. As with Inst, a terrain triangle becomes a Face the first time it is hit,
+// and stays valid until clear().
+
+#ifndef NARCCISSUS_LAND_HPP
+#define NARCCISSUS_LAND_HPP
+
+#include <map>
+#include <mutex>
+#include "Mesh.hpp"
+
+template<typename type>
+class Land {
+    using Vec3 = Vec3<type>;
+    using Face = Face<type>;
+    using Mesh = Mesh<type>;
+    using Range = std::array<type, 2>;
+
+public:
+    // A terrain hit has group "terrain" and the index 2 * cell + triangle, others are hits of the mesh.
+    static constexpr uint64_t terrain = UINT64_MAX;
+
+    using Hit = typename Mesh::Hit;
+
+    // VARIABLES
+    type x0;
+    type z0;
+    type spacing;
+    uint64_t columns;
+    uint64_t rows;
+
+    std::vector<type> heights;
+    std::vector<uint8_t> materials;
+    std::vector<std::vector<Range>> levels;
+
+    Mesh mesh;
+
+    // METHODS
+    type height(const uint64_t &column, const uint64_t &row) const {
+        return heights[row * columns + column];
+    }
+
+    Vec3 point(const uint64_t &column, const uint64_t &row) const {
+        return {x0 + column * spacing, height(column, row), z0 + row * spacing};
+    }
+
+    // The two triangles of a cell, the second one when "upper" is set.
+    Face triangle(const uint64_t &cell, const bool &upper) const {
+        uint64_t c = cell % (columns - 1);
+        uint64_t r = cell / (columns - 1);
+        auto material = static_cast<nrcc::Materials>(materials[cell]);
+        if (upper) return {point(c, r), point(c + 1, r + 1), point(c, r + 1), material};
+        return {point(c, r), point(c + 1, r), point(c + 1, r + 1), material};
+    }
+
+    // Closest terrain or mesh face hit by a ray before limit. A miss has an infinite distance.
+    Hit intersect(const Vec3 &origin, const Vec3 &direct, const type &limit = nrcc::infinity) const {
+        Hit hit = mesh.intersect(origin, direct, limit);
+        if (levels.empty()) return hit;
+
+        type bound = std::min(hit.distance, limit);
+        uint64_t found;
+        if (visit(levels.size() - 1, 0, 0, origin, direct, bound, found)) hit = {bound, terrain, found};
+        return hit;
+    }
+
+    bool occluded(const Vec3 &origin, const Vec3 &target) const {
+        if (mesh.occluded(origin, target)) return true;
+        if (levels.empty()) return false;
+
+        Vec3 direct = (target - origin).unit();
+        type limit = range(origin, target) - nrcc::epsilon;
+        uint64_t found;
+        return visit(levels.size() - 1, 0, 0, origin, direct, limit, found);
+    }
+
+    Face &face(const Hit &hit) {
+        if (hit.group != terrain) return mesh.face(hit);
+
+        std::lock_guard lock(mutex);
+        auto made = faces.find(hit.index);
+        if (made != faces.end()) return made->second;
+        return faces.emplace(hit.index, triangle(hit.index / 2, hit.index % 2)).first->second;
+    }
+
+    // The terrain as triangles, as a scene without a heightfield would hold it.
+    std::vector<Face> triangulate() const {
+        std::vector<Face> triangles;
+        for (uint64_t cell = 0; cell < materials.size(); cell++) {
+            triangles.push_back(triangle(cell, false));
+            triangles.push_back(triangle(cell, true));
+        }
+        return triangles;
+    }
+
+    void clear() {
+        std::lock_guard lock(mutex);
+        faces.clear();
+    }
+
+    uint64_t bytes() const {
+        uint64_t n = heights.size() * sizeof(type) + materials.size();
+        for (const auto &level: levels) n += level.size() * sizeof(Range);
+        return n;
+    }
+
+    // CONSTRUCTORS
+    // Elevations by rows of "columns" samples, x = x0 + column * spacing and z = z0 + row * spacing, and one material
+    // per cell by rows of columns - 1 cells. A grid that does not match its sizes leaves the terrain empty.
+    Land(const type &x0, const type &z0, const type &spacing, const uint64_t &columns, const uint64_t &rows,
+         const std::vector<type> &heights, const std::vector<nrcc::Materials> &cell_materials) :
+            x0(x0), z0(z0), spacing(spacing), columns(columns), rows(rows), heights(heights),
+            materials(cell_materials.begin(), cell_materials.end()) {
+        if (columns < 2 || rows < 2 || !(spacing > 0) || heights.size() != columns * rows ||
+            cell_materials.size() != (columns - 1) * (rows - 1)) {
+            std::cerr << "Error: Terrain needs at least 2 by 2 samples, a positive spacing, columns * rows heights and "
+                         "(columns - 1) * (rows - 1) materials\n";
+            this->columns = 0;
+            this->rows = 0;
+            this->heights.clear();
+            materials.clear();
+            return;
+        }
+
+        uint64_t w = columns - 1;
+        uint64_t h = rows - 1;
+
+        levels.emplace_back(w * h);
+        for (uint64_t r = 0; r < h; r++) {
+            for (uint64_t c = 0; c < w; c++) {
+                std::array<type, 4> corners = {height(c, r), height(c + 1, r), height(c, r + 1), height(c + 1, r + 1)};
+                levels[0][r * w + c] = {*std::min_element(corners.begin(), corners.end()),
+                                        *std::max_element(corners.begin(), corners.end())};
+            }
+        }
+
+        level_columns = {w};
+        level_rows = {h};
+        while (w > 1 || h > 1) {
+            uint64_t pw = (w + 1) / 2;
+            uint64_t ph = (h + 1) / 2;
+            std::vector<Range> level(pw * ph, Range{nrcc::infinity, -nrcc::infinity});
+            for (uint64_t r = 0; r < h; r++) {
+                for (uint64_t c = 0; c < w; c++) {
+                    const Range &child = levels.back()[r * w + c];
+                    Range &parent = level[(r / 2) * pw + c / 2];
+                    parent = {std::min(parent[0], child[0]), std::max(parent[1], child[1])};
+                }
+            }
+            levels.push_back(std::move(level));
+            level_columns.push_back(w = pw);
+            level_rows.push_back(h = ph);
+        }
+    }
+
+private:
+    std::vector<uint64_t> level_columns;
+    std::vector<uint64_t> level_rows;
+
+    std::map<uint64_t, Face> faces;
+    std::mutex mutex;
+
+    // Parametric interval over which a ray is within [lower, upper] along one axis.
+    static Range slab(const type &origin, const type &direct, const type &lower, const type &upper) {
+        if (direct == 0) return origin < lower || origin > upper ? Range{1, 0} : Range{0, nrcc::infinity};
+        type t0 = (lower - origin) / direct;
+        type t1 = (upper - origin) / direct;
+        return t0 < t1 ? Range{t0, t1} : Range{t1, t0};
+    }
+
+    // Entry and exit of a ray over the footprint of a block, empty when entry > exit.
+    Range span(const uint64_t &level, const uint64_t &c, const uint64_t &r, const Vec3 &origin,
+               const Vec3 &direct) const {
+        type size = spacing * (uint64_t(1) << level);
+        type x_end = std::min(x0 + (c + 1) * size, x0 + (columns - 1) * spacing);
+        type z_end = std::min(z0 + (r + 1) * size, z0 + (rows - 1) * spacing);
+        Range x = slab(origin.x, direct.x, x0 + c * size, x_end);
+        Range z = slab(origin.z, direct.z, z0 + r * size, z_end);
+        return {std::max({type(0), x[0], z[0]}), std::min(x[1], z[1])};
+    }
+
+    // Searches a block for the closest triangle hit before limit, which shrinks to each hit, and sets found to its
+    // index. Returns whether there was one.
+    bool visit(const uint64_t &level, const uint64_t &c, const uint64_t &r, const Vec3 &origin, const Vec3 &direct,
+               type &limit, uint64_t &found) const {
+        Range t = span(level, c, r, origin, direct);
+        t[1] = std::min(t[1], limit);
+        if (t[0] > t[1]) return false;
+
+        const Range &block = levels[level][r * level_columns[level] + c];
+        type y0 = origin.y + direct.y * t[0];
+        type y1 = origin.y + direct.y * t[1];
+        if (std::min(y0, y1) > block[1] || std::max(y0, y1) < block[0]) return false;
+
+        if (level == 0) return cell(c, r, origin, direct, limit, found);
+
+        // Nearest corner first, then its two neighbours, then the far corner.
+        uint64_t dc = direct.x < 0;
+        uint64_t dr = direct.z < 0;
+        bool hit = false;
+        for (const auto &[ic, ir]: {std::array<uint64_t, 2>{dc, dr}, {1 - dc, dr}, {dc, 1 - dr}, {1 - dc, 1 - dr}}) {
+            uint64_t cc = 2 * c + ic;
+            uint64_t cr = 2 * r + ir;
+            if (cc >= level_columns[level - 1] || cr >= level_rows[level - 1]) continue;
+            hit = visit(level - 1, cc, cr, origin, direct, limit, found) || hit;
+        }
+        return hit;
+    }
+
+    // The two triangles of cell (c, r) as planes over its square, the lower one where u >= v and the upper one where
+    // u <= v, with u and v running from 0 to 1 along x and z. Same hits and conventions as triangle().
+    bool cell(const uint64_t &c, const uint64_t &r, const Vec3 &origin, const Vec3 &direct, type &limit,
+              uint64_t &found) const {
+        type h00 = height(c, r);
+        type h10 = height(c + 1, r);
+        type h01 = height(c, r + 1);
+        type h11 = height(c + 1, r + 1);
+
+        // Ray in cell coordinates: u = u0 + du t, v = v0 + dv t.
+        type u0 = (origin.x - (x0 + c * spacing)) / spacing;
+        type v0 = (origin.z - (z0 + r * spacing)) / spacing;
+        type du = direct.x / spacing;
+        type dv = direct.z / spacing;
+
+        bool hit = false;
+        for (int upper = 0; upper < 2; upper++) {
+            // Plane y = h00 + a u + b v.
+            type a = upper ? h11 - h01 : h10 - h00;
+            type b = upper ? h01 - h00 : h11 - h10;
+
+            type denominator = direct.y - a * du - b * dv;
+            if (std::fabs(denominator) < nrcc::epsilon) continue;
+
+            type distance = (h00 + a * u0 + b * v0 - origin.y) / denominator;
+            if (!(distance > nrcc::epsilon && distance < limit)) continue;
+
+            type u = u0 + du * distance;
+            type v = v0 + dv * distance;
+            if (u < 0 || u > 1 || v < 0 || v > 1 || (upper ? u > v : u < v)) continue;
+
+            limit = distance;
+            found = 2 * (r * (columns - 1) + c) + upper;
+            hit = true;
+        }
+        return hit;
+    }
+};
+
+#endif //NARCCISSUS_LAND_HPP
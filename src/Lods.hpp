@@ -0,0 +1,128 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Wavelength aware levels of detail. Level 0 is the face set as given. Every further level clusters vertices on a grid
+// twice as coarse as the last: the vertices in a cell collapse onto their mean, and faces left with fewer than three
+// distinct corners, or repeating another face, disappear. Details smaller than a cell, such as window frames or rails,
+// go first while walls keep their shape to within the cell size.
+//
+// Each level records its error, the farthest any vertex moved. A level is usable at a frequency when that error is at
+// most "fraction" of the wavelength. Farther from the transmitter the first Fresnel zone widens, so the per distance
+// choice allows up to fraction * sqrt(wavelength * distance) instead. That is a heuristic: it assumes the receiver is
+// not much closer to the geometry than the transmitter is.
+//
+// Nrcc::closest accepts Lods as a scene, so the trace templates pick a level per wave from its frequency and the path
+// length travelled so far. Faces of different levels never meet in one segment.
+//
+// On the bundled Magnolia scene the levels do not pay off. Its faces are mostly walls of 4 to 128 m^2 with few
+// vertices, so there is little to cluster: at 0.15 GHz the level used near the transmitter keeps all 1249 faces and
+// level 4, used at 300 m, keeps 812. Hit tests are also only about a tenth of a trace to 441 receivers, and even the
+// 380 faces of level 6 shorten them by about a tenth, less than picking a level per wave costs. Merging coplanar
+// clusters with merge() was tried and removed under 5% more faces, so it is not done. The levels are for finely
+// tessellated scenes, where there is detail to drop.
+
+#ifndef NARCCISSUS_LODS_HPP
+#define NARCCISSUS_LODS_HPP
+
+#include <set>
+#include "Face.hpp"
+#include "Mesh.hpp"
+
+template<typename type>
+std::vector<Face<type>> cluster(const std::vector<Face<type>> &faces, const type &cell, type &error) {
+    using Vec3 = Vec3<type>;
+    using Key = std::array<int64_t, 3>;
+
+    auto quantize = [&](const Vec3 &p) {
+        return Key{static_cast<int64_t>(std::floor(p.x / cell)), static_cast<int64_t>(std::floor(p.y / cell)),
+                   static_cast<int64_t>(std::floor(p.z / cell))};
+    };
+
+    std::map<Key, std::pair<Vec3, uint64_t>> sums;
+    for (const auto &face: faces) {
+        for (const auto &point: face.corners()) {
+            auto &[sum, count] = sums.try_emplace(quantize(point), Vec3{0, 0, 0}, 0).first->second;
+            sum = sum + point;
+            count++;
+        }
+    }
+
+    std::map<Key, uint64_t> ids;
+    std::vector<Vec3> means;
+    for (const auto &[key, sum]: sums) {
+        ids[key] = means.size();
+        means.push_back(sum.first / type(sum.second));
+    }
+
+    error = 0;
+    std::vector<Face<type>> clustered;
+    std::set<std::vector<uint64_t>> seen;
+    for (const auto &face: faces) {
+        std::vector<uint64_t> loop;
+        for (const auto &point: face.corners()) {
+            uint64_t id = ids[quantize(point)];
+            error = std::max(error, range(point, means[id]));
+            if (loop.empty() || (loop.back() != id && loop.front() != id)) loop.push_back(id);
+        }
+        if (loop.size() < 3) continue;
+
+        std::vector<uint64_t> sorted = loop;
+        std::sort(sorted.begin(), sorted.end());
+        if (!seen.insert(sorted).second) continue;
+
+        // Polygons may lose corners and are then fanned into triangles, as the remaining loop need not be convex.
+        for (uint64_t i = 1; i + 1 < loop.size(); i++) {
+            const Vec3 &p = means[loop[0]];
+            const Vec3 &q = means[loop[i]];
+            const Vec3 &r = means[loop[i + 1]];
+            if (cross(q - p, r - p).norm() > nrcc::epsilon * cell * cell) clustered.push_back({p, q, r, face.material});
+        }
+    }
+    return clustered;
+}
+
+template<typename type>
+class Lods {
+    using Face = Face<type>;
+    using Mesh = Mesh<type>;
+
+public:
+    // VARIABLES
+    std::vector<Mesh> levels;
+    std::vector<type> errors;
+
+    type fraction = 0.1;
+
+    // METHODS
+    // Coarsest level with an error of at most "tolerance".
+    uint64_t level(const type &tolerance) const {
+        uint64_t l = 0;
+        while (l + 1 < levels.size() && errors[l + 1] <= tolerance) l++;
+        return l;
+    }
+
+    uint64_t level(const type &frequency, const type &distance) const {
+        type wavelength = nrcc::lightspeed / frequency;
+        return level(fraction * std::max(wavelength, std::sqrt(wavelength * distance)));
+    }
+
+    Mesh &mesh(const type &frequency) {
+        return levels[level(frequency, 0)];
+    }
+
+    // CONSTRUCTORS
+    // Level l > 0 clusters on cells of finest * 2^(l - 1).
+    Lods(const std::vector<Face> &faces, const type &finest, const uint64_t &count) {
+        levels.emplace_back(faces);
+        errors.push_back(0);
+
+        type cell = finest;
+        for (uint64_t l = 1; l < count; l++, cell *= 2) {
+            type error;
+            std::vector<Face> clustered = cluster(faces, cell, error);
+            levels.emplace_back(clustered);
+            errors.push_back(std::max(error, errors.back()));
+        }
+    }
+};
+
+#endif //NARCCISSUS_LODS_HPP
@@ -0,0 +1,192 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Scene made of groups of faces. Every group keeps its own tree, and a top level tree over the group boxes combines
+// them. Static groups are built once. Dynamic groups hold moving geometry such as vehicles or doors: after their faces
+// are updated, refit() recomputes their boxes in place instead of rebuilding, and the small top level is rebuilt.
+// A time step then costs a refit plus the trace rather than a reload and full build.
+//
+// Faces are addressed by a hit's group and index. Face pointers stay valid until faces are added to that group.
+//
+// Each group keeps its own copy of the corners of its polygon faces, so they are freed with the mesh. Copying a mesh
+// copies them too and points the copied faces at the copies.
+
+#ifndef NARCCISSUS_MESH_HPP
+#define NARCCISSUS_MESH_HPP
+
+#include "Face.hpp"
+#include "Tree.hpp"
+
+template<typename type>
+class Mesh {
+    using Vec3 = Vec3<type>;
+    using Face = Face<type>;
+    using Tree = Tree<type>;
+
+public:
+    struct Group {
+        std::vector<Face> faces;
+        Tree tree;
+        bool dynamic;
+        std::vector<std::vector<Vec3>> polygons;
+    };
+
+    struct Hit {
+        type distance;
+        uint64_t group;
+        uint64_t index;
+    };
+
+    // VARIABLES
+    std::vector<Group> groups;
+    Tree top;
+
+    // METHODS
+    uint64_t add(const std::vector<Face> &faces, const bool &dynamic = false) {
+        groups.push_back({faces, ::tree(faces), dynamic, {}});
+        adopt(groups.back());
+        build();
+        return groups.size() - 1;
+    }
+
+    Face &face(const Hit &hit) {
+        return groups[hit.group].faces[hit.index];
+    }
+
+    const Face &face(const Hit &hit) const {
+        return groups[hit.group].faces[hit.index];
+    }
+
+    // Flat face ids number the faces of all groups in order, for storing face sequences compactly.
+    uint64_t id(const Hit &hit) const {
+        uint64_t offset = 0;
+        for (uint64_t g = 0; g < hit.group; g++) offset += groups[g].faces.size();
+        return offset + hit.index;
+    }
+
+    Face &face(uint64_t id) {
+        uint64_t g = 0;
+        while (id >= groups[g].faces.size()) id -= groups[g++].faces.size();
+        return groups[g].faces[id];
+    }
+
+    uint64_t size() const {
+        uint64_t n = 0;
+        for (const auto &group: groups) n += group.faces.size();
+        return n;
+    }
+
+    // Replaces the points of a face in a dynamic group, keeping its material. Takes effect on the next refit().
+    void update(const uint64_t &group, const uint64_t &index, const std::array<Vec3, 3> &points) {
+        Face &face = groups[group].faces[index];
+        face = {points[0], points[1], points[2], face.material};
+    }
+
+    // Moves every face of a group, polygon corners in place. Takes effect on the next refit().
+    void translate(const uint64_t &group, const Vec3 &offset) {
+        for (auto &face: groups[group].faces) {
+            for (auto &point: face.points) point = point + offset;
+        }
+        for (auto &polygon: groups[group].polygons) {
+            for (auto &point: polygon) point = point + offset;
+        }
+    }
+
+    void refit() {
+        for (auto &group: groups) {
+            if (!group.dynamic) continue;
+
+            std::vector<std::array<Vec3, 2>> boxes;
+            for (const auto &face: group.faces) boxes.push_back(face.box());
+            group.tree.refit(boxes);
+        }
+        build();
+    }
+
+    // Closest face hit by a ray before limit. A miss has an infinite distance.
+    Hit intersect(const Vec3 &origin, const Vec3 &direct, const type &limit = nrcc::infinity) const {
+        Hit hit = {limit, 0, 0};
+        bool found = false;
+
+        top.traverse(origin, direct, limit, [&](const uint64_t &g, type &top_limit) {
+            const Group &group = groups[g];
+            group.tree.traverse(origin, direct, top_limit, [&](const uint64_t &i, type &group_limit) {
+                type distance = nrcc::intersectionDistance(origin, direct, group.faces[i]);
+                if (distance > nrcc::epsilon && distance < group_limit) {
+                    hit = {distance, g, i};
+                    found = true;
+                    group_limit = distance;
+                    top_limit = distance;
+                }
+                return false;
+            });
+            return false;
+        });
+
+        if (!found) hit.distance = nrcc::infinity;
+        return hit;
+    }
+
+    bool occluded(const Vec3 &origin, const Vec3 &target) const {
+        Vec3 direct = (target - origin).unit();
+        type limit = range(origin, target) - nrcc::epsilon;
+
+        bool blocked = false;
+        top.traverse(origin, direct, limit, [&](const uint64_t &g, type &) {
+            const Group &group = groups[g];
+            group.tree.traverse(origin, direct, limit, [&](const uint64_t &i, type &) {
+                type distance = nrcc::intersectionDistance(origin, direct, group.faces[i]);
+                blocked = distance > nrcc::epsilon && distance < limit;
+                return blocked;
+            });
+            return blocked;
+        });
+        return blocked;
+    }
+
+    // CONSTRUCTORS
+    Mesh() = default;
+
+    Mesh(const std::vector<Face> &statics) {
+        add(statics);
+    }
+
+    Mesh(const Mesh &other) : groups(other.groups), top(other.top) {
+        for (auto &group: groups) adopt(group);
+    }
+
+    Mesh(Mesh &&other) = default;
+
+    Mesh &operator=(const Mesh &other) {
+        if (this == &other) return *this;
+        groups = other.groups;
+        top = other.top;
+        for (auto &group: groups) adopt(group);
+        return *this;
+    }
+
+    Mesh &operator=(Mesh &&other) = default;
+
+private:
+    // Copies the corners of the group's polygon faces into the group and points the faces at the copies.
+    static void adopt(Group &group) {
+        std::vector<std::vector<Vec3>> polygons;
+        for (auto &face: group.faces) {
+            if (face.outline == nullptr) continue;
+            polygons.emplace_back(face.outline, face.outline + face.sides);
+            face.outline = polygons.back().data();
+        }
+        group.polygons = std::move(polygons);
+    }
+
+    void build() {
+        std::vector<std::array<Vec3, 2>> boxes;
+        for (const auto &group: groups) {
+            boxes.push_back(group.tree.empty() ? std::array<Vec3, 2>{Vec3{0, 0, 0}, Vec3{0, 0, 0}}
+                                               : group.tree.nodes[0].box);
+        }
+        top.leaf_size = 1;
+        top.build(boxes);
+    }
+};
+
+#endif //NARCCISSUS_MESH_HPP
@@ -4,40 +4,41 @@
 #define NARCCISSUS_NRCC_HPP
 
 #include "Face.hpp"
+#include "Edge.hpp"
+#include "Mesh.hpp"
+#include "Lods.hpp"
+#include "Inst.hpp"
+#include "Land.hpp"
+#include "Cube.hpp"
 #include "Wave.hpp"
+#include "Taps.hpp"
 
-template<typename type>
+template<typename type, typename policy = nrcc::Policy<>>
 class Nrcc {
     using cmpx = std::complex<type>;
     using VecC = Vec3<cmpx>;
     using Vec3 = Vec3<type>;
     using Face = Face<type>;
     using Wave = Wave<type>;
+    using Edge = Edge<type>;
+    using Wedges = Wedges<type>;
+    using Mesh = Mesh<type>;
+    using Lods = Lods<type>;
+    using Inst = Inst<type>;
+    using Land = Land<type>;
+    using Cube = Cube<type>;
+    using Taps = Taps<type>;
 
 public:
+    // DIFFRACTION BUDGET
+    // Rays launched around each Keller cone, and the most edges a single wave may diffract from.
+    uint64_t keller_rays = 8;
+    uint64_t keller_edges = 2;
 
 // VECTOR - FACE METHODS*/
 
     type intersectionDistance(const Wave &wave, const Face &face) {
-        Vec3 p_vec = cross(wave.direct, face.bounds[1]);
-
-        type det = dot(face.bounds[0], p_vec);
-
-        if (std::fabs(det) < nrcc::epsilon) return -1.0;
-
-        Vec3 t_vec = wave.origin - face.points[0];
-
-        type u = dot(t_vec, p_vec) * (1 / det);
-
-        if (u < 0 || u > 1) return -1.0;
-
-        Vec3 q_vec = cross(t_vec, face.bounds[0]);
-
-        type v = dot(wave.direct, q_vec) * (1 / det);
-
-        if (v < 0 || u + v > 1) return -1.0;
-
-        return dot(face.bounds[1], q_vec) * (1 / det);
+        return nrcc::intersectionDistance(wave.origin, wave.direct, face);
     }
 
     Vec3 intersectionVector(const Wave &wave, const Face &face) {
@@ -59,39 +60,210 @@ public:
         return refc.real().unit();
     }
 
-    Wave reflectedWave(Wave &wave, Face &face) {
+    // OCCLUSION METHODS
+    // Any hit queries for line of sight. Unlike trace, these only ask whether some face lies strictly between origin
+    // and target, so they return on the first one found instead of searching for the closest.
+    bool occluded(const Vec3 &origin, const Vec3 &target, const std::vector<Face> &faces) {
+        Vec3 direct = (target - origin).unit();
+        type limit = range(origin, target) - nrcc::epsilon;
+
+        for (const auto &face: faces) {
+            type distance = nrcc::intersectionDistance(origin, direct, face);
+            if (distance > nrcc::epsilon && distance < limit) return true;
+        }
+        return false;
+    }
+
+    bool occluded(const Vec3 &origin, const Vec3 &target, const std::vector<Face> &faces, const Tree<type> &tree) {
+        Vec3 direct = (target - origin).unit();
+        type limit = range(origin, target) - nrcc::epsilon;
+
+        bool hit = false;
+        tree.traverse(origin, direct, limit, [&](const uint64_t &i, type &) {
+            type distance = nrcc::intersectionDistance(origin, direct, faces[i]);
+            hit = distance > nrcc::epsilon && distance < limit;
+            return hit;
+        });
+        return hit;
+    }
+
+    bool occluded(const Vec3 &origin, const Vec3 &target, const Mesh &mesh) {
+        return mesh.occluded(origin, target);
+    }
+
+    // Batched form over segments {origin, target}. Segments are visited grouped by origin and direction octant so
+    // that consecutive queries walk the same branches of the tree.
+    std::vector<uint8_t> occluded(const std::vector<std::array<Vec3, 2>> &segments, const std::vector<Face> &faces,
+                                  const Tree<type> &tree) {
+        auto octant = [](const Vec3 &d) { return (d.x < 0) | (d.y < 0) << 1 | (d.z < 0) << 2; };
+
+        std::vector<uint64_t> order(segments.size());
+        for (uint64_t i = 0; i < segments.size(); i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](const uint64_t &i, const uint64_t &j) {
+            const Vec3 &a = segments[i][0];
+            const Vec3 &b = segments[j][0];
+            return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z) ||
+                   (std::tie(a.x, a.y, a.z) == std::tie(b.x, b.y, b.z) &&
+                    octant(segments[i][1] - a) < octant(segments[j][1] - b));
+        });
+
+        std::vector<uint8_t> blocked(segments.size());
+        for (const auto &i: order) blocked[i] = occluded(segments[i][0], segments[i][1], faces, tree);
+        return blocked;
+    }
+
+    // Samples the Keller cone of a ray arriving along incident at an edge. All rays keep the incident angle to the edge
+    // and are spread evenly about it over the exterior of the wedge, so none of them start inside either face.
+    std::vector<Vec3> diffractionVectors(const Vec3 &incident, const Edge &edge) {
+        Vec3 e = edge.direct();
+        type cos_b = dot(incident.unit(), e);
+        type sin_b = std::sqrt(std::max(type(0), 1 - cos_b * cos_b));
+
+        type n = edge.wedge();
+
+        std::vector<Vec3> directs;
+        for (uint64_t i = 0; i < keller_rays; i++) {
+            type psi = n * nrcc::pi * (i + 0.5) / keller_rays;
+            directs.push_back(e * cos_b + (edge.tangents[0] * std::cos(psi) + edge.normals[0] * std::sin(psi)) * sin_b);
+        }
+        return directs;
+    }
+
+    Wave reflectedWave(Wave &wave, const Face &face) {
         return {intersectionVector(wave, face), reflectionVector(wave, face), &wave, &face, nrcc::reflection};
     }
 
-    Wave refractedWave(Wave &wave, Face &face) {
+    Wave refractedWave(Wave &wave, const Face &face) {
         return {intersectionVector(wave, face), refractionVector(wave, face), &wave, &face, nrcc::refraction};
     }
 
-    // RECURSIVE TRACE METHOD
-    std::vector<Wave> trace(Wave &wave, std::vector<Face> &faces, const uint8_t &rs) {
-        std::vector<Wave> waves{wave};
+    // Diffracted waves leave from the point of the edge closest to the wave, found at distance along it. The wave only
+    // passes within the capture radius, so the cone is set up for the ray from its origin to that point instead.
+    std::vector<Wave> diffractedWaves(Wave &wave, Edge &edge, const type &distance) {
+        Vec3 e = edge.direct();
+        type s = std::clamp(dot(wave.direct * distance + wave.origin - edge.points[0], e), type(0), edge.length());
+        Vec3 point = edge.points[0] + e * s;
+
+        std::vector<Wave> waves;
+        for (const auto &direct: diffractionVectors(point - wave.origin, edge)) {
+            waves.push_back({point, direct, &wave, &edge});
+        }
+        return waves;
+    }
 
-        bool intersected = false;
-        Face intersecting_face = faces.back();
+    // CLOSEST HIT METHODS
+    // Closest face in front of a wave and its distance, or nullptr if the wave escapes. The trace below is written
+    // against these so it runs on a bare face set as well as on a mesh with trees.
+    Face *closest(const Wave &wave, std::vector<Face> &faces, type &min_distance) {
+        Face *intersecting_face = nullptr;
 
-        type min_distance = nrcc::infinity;
-        for (const auto &face: faces) {
+        min_distance = nrcc::infinity;
+        for (auto &face: faces) {
             type new_distance = intersectionDistance(wave, face);
 
             if (new_distance > nrcc::epsilon && new_distance < min_distance) {
-                intersected = true;
-                intersecting_face = face;
+                intersecting_face = &face;
                 min_distance = new_distance;
             }
         }
+        return intersecting_face;
+    }
+
+    const Face *closest(const Wave &wave, const Mesh &mesh, type &min_distance) {
+        typename Mesh::Hit hit = mesh.intersect(wave.origin, wave.direct);
+
+        min_distance = hit.distance;
+        return hit.distance < nrcc::infinity ? &mesh.face(hit) : nullptr;
+    }
+
+    Face *closest(const Wave &wave, Inst &inst, type &min_distance) {
+        typename Inst::Hit hit = inst.intersect(wave.origin, wave.direct);
+
+        min_distance = hit.distance;
+        return hit.distance < nrcc::infinity ? &inst.face(hit) : nullptr;
+    }
+
+    Face *closest(const Wave &wave, Land &land, type &min_distance) {
+        typename Land::Hit hit = land.intersect(wave.origin, wave.direct);
+
+        min_distance = hit.distance;
+        return hit.distance < nrcc::infinity ? &land.face(hit) : nullptr;
+    }
+
+    // Waves launched from the centre of the cube map take their first hit from it.
+    Face *closest(const Wave &wave, Cube &cube, type &min_distance) {
+        typename Mesh::Hit hit = wave.genesis.wave == nullptr ? cube.first(wave.origin, wave.direct)
+                                                              : cube.mesh.intersect(wave.origin, wave.direct);
+
+        min_distance = hit.distance;
+        return hit.distance < nrcc::infinity ? &cube.mesh.face(hit) : nullptr;
+    }
+
+    // Traces each wave in the level of detail allowed by its frequency and the path length up to its origin.
+    Face *closest(Wave &wave, Lods &lods, type &min_distance) {
+        type travelled = 0;
+        for (Wave *w = &wave; w->genesis.wave != nullptr; w = w->genesis.wave) travelled += w->genesis.distance;
+
+        return closest(wave, lods.levels[lods.level(wave.frequency(0), travelled)], min_distance);
+    }
+
+    // RECURSIVE TRACE METHOD
+    std::vector<Wave> trace(Wave &wave, std::vector<Face> &faces, const uint8_t &rs) {
+        return trace(wave, faces, nullptr, rs);
+    }
+
+    std::vector<Wave> trace(Wave &wave, const Mesh &mesh, const uint8_t &rs) {
+        return trace(wave, mesh, nullptr, rs);
+    }
+
+    // Diffraction is spawned from at most keller_edges edges passing within the wedge radius of the wave before its
+    // closest hit, each with keller_rays rays, so diffraction adds a bounded number of rays per wave.
+    std::vector<Wave> trace(Wave &wave, std::vector<Face> &faces, Wedges &wedges, const uint8_t &rs) {
+        return trace(wave, faces, &wedges, rs);
+    }
+
+    std::vector<Wave> trace(Wave &wave, const Mesh &mesh, Wedges &wedges, const uint8_t &rs) {
+        return trace(wave, mesh, &wedges, rs);
+    }
+
+    template<typename Scene>
+    std::vector<Wave> trace(Wave &wave, Scene &scene, Wedges *wedges, const uint8_t &rs) {
+        std::vector<Wave> waves{wave};
+
+        type min_distance;
+        const Face *hit_face = closest(wave, scene, min_distance);
+
+        bool intersected = hit_face != nullptr;
+
+        if (wedges != nullptr) {
+            std::vector<std::pair<type, Edge *>> near;
+            wedges->near(wave.origin, wave.direct, min_distance, [&](Edge &edge, const type &t) {
+                near.push_back({t, &edge});
+            });
+            std::sort(near.begin(), near.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+            if (near.size() > keller_edges) near.resize(keller_edges);
+
+            for (const auto &[distance, edge]: near) {
+                for (Wave &diffract_wave: diffractedWaves(wave, *edge, distance)) {
+                    if (rs > 1) {
+                        std::vector<Wave> diffraction_traced = trace(diffract_wave, scene, wedges, rs - 1);
+                        waves.insert(waves.end(), diffraction_traced.begin(), diffraction_traced.end());
+                    }
+                    else waves.push_back(diffract_wave);
+                }
+            }
+        }
+
         // TODO: The below should be rewritten to allow for const declarations in wave and face
         if (intersected) {
+            Face intersecting_face = *hit_face;
+
             if (rs > 1) {
                 Wave reflect_wave = reflectedWave(wave, intersecting_face);
                 Wave refract_wave = refractedWave(wave, intersecting_face);
 
-                std::vector<Wave> reflection_traced = trace(reflect_wave, faces, rs - 1);
-                std::vector<Wave> refraction_traced = trace(refract_wave, faces, rs - 1);
+                std::vector<Wave> reflection_traced = trace(reflect_wave, scene, wedges, rs - 1);
+                std::vector<Wave> refraction_traced = trace(refract_wave, scene, wedges, rs - 1);
 
                 waves.insert(waves.end(), reflection_traced.begin(), reflection_traced.end());
                 waves.insert(waves.end(), refraction_traced.begin(), refraction_traced.end());
@@ -103,6 +275,76 @@ public:
         }
         return waves;
     }
+
+    // STREAMING TRACE METHOD
+    // Same recursion as above, but instead of returning the waves, each one is offered to the receivers while its
+    // parents are still alive on the stack, and is then dropped. Memory stays bounded by the receiver accumulators.
+    // Diffraction is not followed: wedges are only taken by the vector returning traces.
+    template<typename Scene>
+    void trace(Wave &wave, Scene &scene, std::vector<Taps> &receivers, const uint8_t &rs) {
+        type min_distance;
+        const Face *hit_face = closest(wave, scene, min_distance);
+
+        for (auto &receiver: receivers) receiver.receive(wave, min_distance);
+
+        if (hit_face == nullptr || rs == 0) return;
+
+        Face intersecting_face = *hit_face;
+
+        Wave reflect_wave = reflectedWave(wave, intersecting_face);
+        Wave refract_wave = refractedWave(wave, intersecting_face);
+
+        trace(reflect_wave, scene, receivers, rs - 1);
+        trace(refract_wave, scene, receivers, rs - 1);
+    }
+
+    // POLICY TRACE METHODS
+    // The streaming trace specialized by policy. Depth is a template argument, so the recursion is expanded at compile
+    // time and the last level carries no hit test or branching, and disabled interactions are never spawned. Like the
+    // streaming trace these follow reflection and refraction only, not diffraction.
+    template<typename Scene>
+    void trace(Wave &wave, Scene &scene, std::vector<Taps> &receivers) {
+        static_assert(policy::receive, "policy collects waves, use trace(wave, scene)");
+        std::vector<Wave> waves;
+        bounce<policy::depth>(wave, scene, receivers, waves);
+    }
+
+    template<typename Scene>
+    std::vector<Wave> trace(Wave &wave, Scene &scene) {
+        static_assert(!policy::receive, "policy tests receivers, use trace(wave, scene, receivers)");
+        std::vector<Taps> receivers;
+        std::vector<Wave> waves;
+        bounce<policy::depth>(wave, scene, receivers, waves);
+        return waves;
+    }
+
+private:
+    template<uint8_t rs, typename Scene>
+    void bounce(Wave &wave, Scene &scene, std::vector<Taps> &receivers, std::vector<Wave> &waves) {
+        if constexpr (policy::eager) wave.polar(0);
+        if constexpr (!policy::receive) waves.push_back(wave);
+        if constexpr (!policy::receive && rs == 0) return;
+
+        type min_distance;
+        const Face *hit_face = closest(wave, scene, min_distance);
+
+        if constexpr (policy::receive) {
+            for (auto &receiver: receivers) receiver.receive(wave, min_distance);
+        }
+
+        if constexpr (rs > 0) {
+            if (hit_face == nullptr) return;
+
+            if constexpr (policy::reflection) {
+                Wave reflect_wave = reflectedWave(wave, *hit_face);
+                bounce<rs - 1>(reflect_wave, scene, receivers, waves);
+            }
+            if constexpr (policy::refraction) {
+                Wave refract_wave = refractedWave(wave, *hit_face);
+                bounce<rs - 1>(refract_wave, scene, receivers, waves);
+            }
+        }
+    }
 };
 
 #endif //NARCCISSUS_NRCC_HPP
\ No newline at end of file
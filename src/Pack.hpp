@@ -0,0 +1,304 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Compact on-disk path sets. Rather than waves, each path is stored as
+//
+//   launch index, transmitter and receiver indices      varints
+//   interaction count                                   varint
+//   face ids                                            zigzag varints, each relative to the previous face
+//   interaction kinds                                   2 bits each
+//   segment directions                                  octahedral, "bits" per component in 2 bytes
+//
+// which is around 16 bytes for a two bounce path. Endpoints are shared through a table in the header. Interaction
+// points and lengths are not stored: on load each segment is cut at the plane of its next face, starting from the
+// transmitter, and the last one ends at the receiver, so only segments ending on a face keep a direction. The mesh the
+// paths were traced in must be supplied. "bits" is at most 16, and at 16 bits directions are good to about 5e-5
+// radians, so rebuilt points drift by around a centimetre per hundred metres of path.
+//
+// Records are variable length. The file ends with the offset of every "block"-th record and the position of that
+// table, so any path is found by one seek and at most block - 1 skipped records.
+//
+// Packs are checked as they are read: a header whose counts do not fit the file is refused, leaving an empty pack, and
+// a record that ends early or indexes past the endpoints or the faces of the mesh reads as an empty path.
+
+#ifndef NARCCISSUS_PACK_HPP
+#define NARCCISSUS_PACK_HPP
+
+#include <fstream>
+#include <map>
+#include "Mesh.hpp"
+#include "Path.hpp"
+
+template<typename type>
+class Pack {
+    using Vec3 = Vec3<type>;
+    using Face = Face<type>;
+    using Mesh = Mesh<type>;
+    using Path = Path<type>;
+
+public:
+    static constexpr uint32_t magic = 0x4B434150;
+    static constexpr uint32_t version = 2;
+    static constexpr uint64_t block = 16;
+
+    // VARIABLES
+    Mesh &mesh;
+    std::vector<Vec3> endpoints;
+    uint64_t count = 0;
+    uint8_t bits = 16;
+
+    // METHODS
+    static bool write(const std::string &file, const std::vector<Path> &paths, const uint8_t &bits = 16) {
+        if (bits < 1 || bits > 16) {
+            std::cerr << "Error: Directions take 1 to 16 bits per component\n";
+            return false;
+        }
+
+        std::map<std::array<type, 3>, uint64_t> table;
+        std::vector<Vec3> endpoints;
+        auto endpoint = [&](const Vec3 &p) {
+            auto [found, added] = table.insert({{p.x, p.y, p.z}, endpoints.size()});
+            if (added) endpoints.push_back(p);
+            return found->second;
+        };
+
+        std::string records;
+        std::vector<uint64_t> offsets;
+        for (uint64_t i = 0; i < paths.size(); i++) {
+            if (i % block == 0) offsets.push_back(records.size());
+
+            const Path &path = paths[i];
+            uint64_t k = path.faces.size();
+
+            varint(records, path.launch);
+            varint(records, endpoint(path.points.front()));
+            varint(records, endpoint(path.points.back()));
+            varint(records, k);
+
+            int64_t previous = 0;
+            for (const auto &face: path.faces) {
+                int64_t delta = static_cast<int64_t>(face) - previous;
+                varint(records, static_cast<uint64_t>(delta << 1) ^ static_cast<uint64_t>(delta >> 63));
+                previous = static_cast<int64_t>(face);
+            }
+
+            for (uint64_t j = 0; j < k; j += 4) {
+                uint8_t packed = 0;
+                for (uint64_t m = j; m < std::min(k, j + 4); m++) packed |= path.interactions[m] << 2 * (m - j);
+                records.push_back(static_cast<char>(packed));
+            }
+
+            for (uint64_t j = 0; j < k; j++) {
+                std::array<uint16_t, 2> q = encode((path.points[j + 1] - path.points[j]).unit(), bits);
+                records.append(reinterpret_cast<const char *>(q.data()), sizeof(q));
+            }
+        }
+
+        std::ofstream out(file, std::ofstream::binary);
+        auto put = [&](const auto &value) { out.write(reinterpret_cast<const char *>(&value), sizeof(value)); };
+
+        put(magic);
+        put(version);
+        put(bits);
+        put(static_cast<uint64_t>(paths.size()));
+        put(static_cast<uint64_t>(endpoints.size()));
+        for (const auto &p: endpoints) {
+            put(p.x);
+            put(p.y);
+            put(p.z);
+        }
+
+        uint64_t start = static_cast<uint64_t>(out.tellp());
+        out.write(records.data(), records.size());
+
+        uint64_t table_position = static_cast<uint64_t>(out.tellp());
+        for (const auto &offset: offsets) put(start + offset);
+        put(table_position);
+
+        return static_cast<bool>(out);
+    }
+
+    uint64_t size() const {
+        return count;
+    }
+
+    // The i-th path, or an empty one past the end or if the record is corrupt.
+    Path read(const uint64_t &i) {
+        if (i >= count) return {};
+
+        in.clear();
+        in.seekg(offsets[i / block]);
+        Path path;
+        for (uint64_t skip = 0; skip <= i % block; skip++) {
+            if (!decode(path)) return {};
+        }
+        return path;
+    }
+
+    // Up to n paths from the first, stopping at the end or at a corrupt record.
+    std::vector<Path> read(const uint64_t &first, const uint64_t &n) {
+        std::vector<Path> paths;
+        if (first >= count) return paths;
+
+        in.clear();
+        in.seekg(offsets[first / block]);
+        Path path;
+        for (uint64_t skip = 0; skip < first % block; skip++) {
+            if (!decode(path)) return paths;
+        }
+        for (uint64_t i = first; i < std::min(count, first + n); i++) {
+            if (!decode(path)) break;
+            paths.push_back(path);
+        }
+        return paths;
+    }
+
+    // CONSTRUCTORS
+    Pack(const std::string &file, Mesh &mesh) : mesh(mesh), in(file, std::ifstream::binary) {
+        auto get = [&](auto &value) { in.read(reinterpret_cast<char *>(&value), sizeof(value)); };
+
+        uint32_t m = 0;
+        uint32_t v = 0;
+        get(m);
+        get(v);
+        if (!in || m != magic || v != version) {
+            std::cerr << "Error: Not a path pack\n";
+            return;
+        }
+
+        uint64_t n = 0;
+        get(bits);
+        get(count);
+        get(n);
+
+        // Every count must fit in the file before anything is sized by it.
+        uint64_t header = static_cast<uint64_t>(in.tellg());
+        in.seekg(0, std::ifstream::end);
+        uint64_t size = static_cast<uint64_t>(in.tellg());
+        uint64_t blocks = count / block + (count % block != 0);
+
+        uint64_t table_position = 0;
+        in.seekg(-static_cast<std::streamoff>(sizeof(uint64_t)), std::ifstream::end);
+        get(table_position);
+
+        if (!in || bits < 1 || bits > 16 || n > (size - header) / (3 * sizeof(type)) ||
+            table_position < header + n * 3 * sizeof(type) || table_position > size - sizeof(uint64_t) ||
+            blocks != (size - sizeof(uint64_t) - table_position) / sizeof(uint64_t)) {
+            std::cerr << "Error: Corrupt path pack header\n";
+            count = 0;
+            return;
+        }
+
+        in.seekg(header);
+        endpoints.resize(n);
+        for (auto &p: endpoints) {
+            get(p.x);
+            get(p.y);
+            get(p.z);
+        }
+
+        offsets.resize(blocks);
+        in.seekg(table_position);
+        for (auto &offset: offsets) get(offset);
+    }
+
+private:
+    std::ifstream in;
+    std::vector<uint64_t> offsets;
+
+    // Reads the next record into path. Returns false if it ends early or indexes past the endpoints or the mesh.
+    bool decode(Path &path) {
+        path = {};
+        path.launch = varint(in);
+        uint64_t transmitter = varint(in);
+        uint64_t receiver = varint(in);
+        uint64_t k = varint(in);
+        if (!in || transmitter >= endpoints.size() || receiver >= endpoints.size()) return corrupt();
+
+        int64_t previous = 0;
+        for (uint64_t j = 0; j < k; j++) {
+            uint64_t z = varint(in);
+            previous += static_cast<int64_t>(z >> 1) ^ -static_cast<int64_t>(z & 1);
+            if (!in || previous < 0 || static_cast<uint64_t>(previous) >= mesh.size()) return corrupt();
+            path.faces.push_back(previous);
+        }
+
+        for (uint64_t j = 0; j < k; j += 4) {
+            uint8_t packed = in.get();
+            for (uint64_t m = j; m < std::min(k, j + 4); m++) {
+                path.interactions.push_back(static_cast<nrcc::Interactions>(packed >> 2 * (m - j) & 3));
+            }
+        }
+
+        path.points = {endpoints[transmitter]};
+        for (uint64_t j = 0; j < k; j++) {
+            std::array<uint16_t, 2> q;
+            in.read(reinterpret_cast<char *>(q.data()), sizeof(q));
+
+            Vec3 direct = decode(q, bits);
+            const Face &face = mesh.face(path.faces[j]);
+            Vec3 n = face.normal();
+            type t = dot(face.points[0] - path.points.back(), n) / dot(direct, n);
+            path.points.push_back(path.points.back() + direct * t);
+        }
+        path.points.push_back(endpoints[receiver]);
+
+        if (!in) return corrupt();
+        return true;
+    }
+
+    static bool corrupt() {
+        std::cerr << "Error: Corrupt path record\n";
+        return false;
+    }
+
+    static void varint(std::string &bytes, uint64_t value) {
+        while (value >= 0x80) {
+            bytes.push_back(static_cast<char>((value & 0x7F) | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<char>(value));
+    }
+
+    static uint64_t varint(std::istream &is) {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t byte = is.get();
+            value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        return value;
+    }
+
+    // Octahedral mapping of a unit vector onto [-1, 1]^2, quantized to the given bits per component.
+    static std::array<uint16_t, 2> encode(const Vec3 &v, const uint8_t &bits) {
+        type l = std::fabs(v.x) + std::fabs(v.y) + std::fabs(v.z);
+        type u = v.x / l;
+        type w = v.y / l;
+        if (v.z < 0) {
+            type a = (1 - std::fabs(w)) * (u < 0 ? -1 : 1);
+            type b = (1 - std::fabs(u)) * (w < 0 ? -1 : 1);
+            u = a;
+            w = b;
+        }
+
+        type scale = (1 << bits) - 1;
+        return {static_cast<uint16_t>(std::round((u * 0.5 + 0.5) * scale)),
+                static_cast<uint16_t>(std::round((w * 0.5 + 0.5) * scale))};
+    }
+
+    static Vec3 decode(const std::array<uint16_t, 2> &q, const uint8_t &bits) {
+        type scale = (1 << bits) - 1;
+        type u = q[0] / scale * 2 - 1;
+        type w = q[1] / scale * 2 - 1;
+        type z = 1 - std::fabs(u) - std::fabs(w);
+        if (z < 0) {
+            type a = (1 - std::fabs(w)) * (u < 0 ? -1 : 1);
+            type b = (1 - std::fabs(u)) * (w < 0 ? -1 : 1);
+            u = a;
+            w = b;
+        }
+        return Vec3{u, w, z}.unit();
+    }
+};
+
+#endif //NARCCISSUS_PACK_HPP
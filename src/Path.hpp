@@ -0,0 +1,293 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Propagation paths between one transmitter and one receiver. A path is kept as the launch direction it was found
+// from, the faces it interacts with (flat mesh ids), the kind of each interaction and the points where they happen,
+// starting at the transmitter and ending at the receiver. Unlike waves it holds no EM state, so it can be re-solved
+// when either end moves.
+//
+// Track follows a transmitter or receiver along a route. The first position is traced in full. At every following
+// position each known path is re-solved for its face sequence: image sources for pure reflection, and otherwise by
+// shooting along the sequence and correcting the launch direction until the ray passes through the receiver. Re-solved
+// paths are checked with occlusion queries. Launch cones around paths that broke are retraced, which is where new paths
+// are most likely to have appeared. Paths appearing elsewhere are only picked up by the full retrace every "refresh"
+// steps.
+
+#ifndef NARCCISSUS_PATH_HPP
+#define NARCCISSUS_PATH_HPP
+
+#include <set>
+#include "Mesh.hpp"
+#include "Nrcc.hpp"
+
+template<typename type>
+struct Path {
+    using Vec3 = Vec3<type>;
+
+    // VARIABLES
+    uint64_t launch;
+    std::vector<uint64_t> faces;
+    std::vector<nrcc::Interactions> interactions;
+    std::vector<Vec3> points;
+
+    // METHODS
+    type length() const {
+        type l = 0;
+        for (uint64_t i = 1; i < points.size(); i++) l += range(points[i - 1], points[i]);
+        return l;
+    }
+
+    bool reflective() const {
+        for (const auto &interaction: interactions) {
+            if (interaction != nrcc::reflection) return false;
+        }
+        return true;
+    }
+
+    // Identifies a path by its face and interaction sequence alone.
+    std::vector<uint64_t> sequence() const {
+        std::vector<uint64_t> s;
+        for (uint64_t i = 0; i < faces.size(); i++) s.push_back(faces[i] << 2 | interactions[i]);
+        return s;
+    }
+};
+
+template<typename type>
+class Track {
+    using Vec3 = Vec3<type>;
+    using Face = Face<type>;
+    using Wave = Wave<type>;
+    using Mesh = Mesh<type>;
+    using Path = Path<type>;
+
+public:
+    // VARIABLES
+    Mesh &mesh;
+    std::vector<Vec3> directions;
+    type frequency;
+    type radius;
+    uint8_t depth;
+
+    uint64_t refresh = 0;
+    uint64_t iterations = 8;
+
+    Vec3 transmitter;
+    Vec3 receiver;
+    std::vector<Path> paths;
+
+    uint64_t steps = 0;
+    uint64_t retraced = 0;
+
+    // METHODS
+    void start(const Vec3 &tx, const Vec3 &rx) {
+        transmitter = tx;
+        receiver = rx;
+        steps = 0;
+
+        paths.clear();
+        retrace(std::vector<uint8_t>(directions.size(), 1));
+    }
+
+    void step(const Vec3 &tx, const Vec3 &rx) {
+        transmitter = tx;
+        receiver = rx;
+        steps++;
+
+        if (refresh > 0 && steps % refresh == 0) {
+            paths.clear();
+            return retrace(std::vector<uint8_t>(directions.size(), 1));
+        }
+
+        std::vector<uint8_t> dirty(directions.size(), 0);
+        std::vector<Path> kept;
+        for (auto &path: paths) {
+            if (solve(path)) kept.push_back(path);
+            else cone(path.launch, dirty);
+        }
+        paths = kept;
+
+        retrace(dirty);
+    }
+
+    // Exact geometry of a path for the current transmitter and receiver. Returns false if the face sequence no longer
+    // connects them or a segment is blocked.
+    bool solve(Path &path) {
+        bool solved = path.reflective() ? image(path) : shoot(path);
+        if (!solved) return false;
+
+        for (uint64_t i = 1; i < path.points.size(); i++) {
+            if (mesh.occluded(path.points[i - 1], path.points[i])) return false;
+        }
+        path.launch = nearest((path.points[1] - path.points[0]).unit());
+        return true;
+    }
+
+    // CONSTRUCTORS
+    Track(Mesh &mesh, const std::vector<Vec3> &directions, const type &frequency, const type &radius,
+          const uint8_t &depth) :
+            mesh(mesh), directions(directions), frequency(frequency), radius(radius), depth(depth) {}
+
+private:
+    Nrcc<type> tracer;
+
+    // Traces the flagged launch directions in full, adding every path not already known.
+    void retrace(const std::vector<uint8_t> &launches) {
+        std::set<std::vector<uint64_t>> known;
+        for (const auto &path: paths) known.insert(path.sequence());
+
+        retraced = 0;
+        for (uint64_t i = 0; i < directions.size(); i++) {
+            if (!launches[i]) continue;
+            retraced++;
+
+            Wave wave = {transmitter, directions[i], frequency, 1, 0, nrcc::polarization::linear};
+            Path prefix = {i, {}, {}, {transmitter}};
+            std::vector<Path> found;
+            walk(wave, prefix, found);
+
+            for (auto &path: found) {
+                if (known.contains(path.sequence()) || !solve(path)) continue;
+                known.insert(path.sequence());
+                paths.push_back(path);
+            }
+        }
+    }
+
+    void walk(Wave &wave, Path &prefix, std::vector<Path> &found) {
+        typename Mesh::Hit hit = mesh.intersect(wave.origin, wave.direct);
+
+        type d = nrcc::intersectionDistance(wave.origin, wave.direct, receiver, radius);
+        if (d > 0 && d < hit.distance) {
+            found.push_back(prefix);
+            found.back().points.push_back(receiver);
+        }
+
+        if (hit.distance == nrcc::infinity || prefix.faces.size() >= depth) return;
+
+        Face &face = mesh.face(hit);
+        Vec3 point = wave.origin + wave.direct * hit.distance;
+
+        for (const auto &interaction: {nrcc::reflection, nrcc::refraction}) {
+            Wave child = interaction == nrcc::reflection ? tracer.reflectedWave(wave, face)
+                                                         : tracer.refractedWave(wave, face);
+            prefix.faces.push_back(mesh.id(hit));
+            prefix.interactions.push_back(interaction);
+            prefix.points.push_back(point);
+
+            walk(child, prefix, found);
+
+            prefix.faces.pop_back();
+            prefix.interactions.pop_back();
+            prefix.points.pop_back();
+        }
+    }
+
+    // Mirrors the transmitter through each face in turn, then walks back from the receiver towards each image.
+    bool image(Path &path) {
+        uint64_t k = path.faces.size();
+
+        std::vector<Vec3> images{transmitter};
+        for (const auto &id: path.faces) {
+            const Face &face = mesh.face(id);
+            Vec3 n = face.normal();
+            images.push_back(images.back() - n * (dot(images.back() - face.points[0], n) * 2));
+        }
+
+        std::vector<Vec3> points(k + 2);
+        points[0] = transmitter;
+        points[k + 1] = receiver;
+        for (uint64_t j = k; j > 0; j--) {
+            Vec3 direct = (images[j] - points[j + 1]).unit();
+            type t = nrcc::intersectionDistance(points[j + 1], direct, mesh.face(path.faces[j - 1]));
+            if (t <= nrcc::epsilon) return false;
+            points[j] = points[j + 1] + direct * t;
+        }
+        path.points = points;
+        return true;
+    }
+
+    // Follows the face sequence from a launch direction and returns how far the last segment passes from the
+    // receiver, or infinity if the ray leaves the sequence.
+    type follow(const Path &path, const Vec3 &direct, std::vector<Vec3> &points, Vec3 &miss) {
+        Wave wave = {transmitter, direct, frequency, 1, 0, nrcc::polarization::linear};
+        points = {transmitter};
+
+        for (uint64_t j = 0; j < path.faces.size(); j++) {
+            Face &face = mesh.face(path.faces[j]);
+            if (tracer.intersectionDistance(wave, face) <= nrcc::epsilon) return nrcc::infinity;
+
+            Wave next = path.interactions[j] == nrcc::reflection ? tracer.reflectedWave(wave, face)
+                                                                 : tracer.refractedWave(wave, face);
+            points.push_back(next.origin);
+            wave = next;
+        }
+
+        Vec3 v = receiver - wave.origin;
+        type s = dot(v, wave.direct);
+        if (s <= 0) return nrcc::infinity;
+
+        points.push_back(receiver);
+        miss = v - wave.direct * s;
+        return miss.norm();
+    }
+
+    // Gauss-Newton on the launch elevation and azimuth, with a finite difference jacobian of the miss vector.
+    bool shoot(Path &path) {
+        Vec3 launch = (path.points[1] - path.points[0]).unit();
+        type el = launch.EL();
+        type az = launch.AZ();
+
+        type h = 1e-7;
+        type tolerance = 1e-6 * std::max(type(1), path.length());
+
+        std::vector<Vec3> points;
+        Vec3 miss;
+        for (uint64_t i = 0; i < iterations; i++) {
+            type error = follow(path, {el, az}, points, miss);
+            if (error == nrcc::infinity) return false;
+            if (error < tolerance) {
+                path.points = points;
+                return true;
+            }
+
+            std::vector<Vec3> unused;
+            Vec3 miss_el;
+            Vec3 miss_az;
+            if (follow(path, {el + h, az}, unused, miss_el) == nrcc::infinity) return false;
+            if (follow(path, {el, az + h}, unused, miss_az) == nrcc::infinity) return false;
+
+            Vec3 j_el = (miss_el - miss) / h;
+            Vec3 j_az = (miss_az - miss) / h;
+
+            type a = dot(j_el, j_el);
+            type b = dot(j_el, j_az);
+            type c = dot(j_az, j_az);
+            type det = a * c - b * b;
+            if (std::fabs(det) < nrcc::epsilon * nrcc::epsilon) return false;
+
+            type g_el = -dot(j_el, miss);
+            type g_az = -dot(j_az, miss);
+            el += (c * g_el - b * g_az) / det;
+            az += (a * g_az - b * g_el) / det;
+        }
+        return false;
+    }
+
+    // Flags every launch direction within two grid spacings of the given one.
+    void cone(const uint64_t &launch, std::vector<uint8_t> &dirty) {
+        type spacing = std::sqrt(4 * nrcc::pi / directions.size());
+        type cos_cone = std::cos(2 * spacing);
+        for (uint64_t i = 0; i < directions.size(); i++) {
+            if (dot(directions[i], directions[launch]) > cos_cone) dirty[i] = 1;
+        }
+    }
+
+    uint64_t nearest(const Vec3 &direct) {
+        uint64_t best = 0;
+        for (uint64_t i = 1; i < directions.size(); i++) {
+            if (dot(directions[i], direct) > dot(directions[best], direct)) best = i;
+        }
+        return best;
+    }
+};
+
+#endif //NARCCISSUS_PATH_HPP
@@ -4,6 +4,7 @@
 #define NARCCISSUS_POLE_HPP
 
 #include "Wave.hpp"
+#include "Gain.hpp"
 
 template<typename type>
 class Pole {
@@ -11,6 +12,7 @@ class Pole {
     using VecC = Vec3<cmpx>;
     using Vec3 = Vec3<type>;
     using Wave = Wave<type>;
+    using Gain = Gain<type>;
 
 public:
     Vec3 coordinates;
@@ -18,33 +20,74 @@ public:
     type frequency;
     type length;
 
+    // Tabulated pattern replacing the dipole when set. Not owned, and must outlive the pole.
+    const Gain *pattern = nullptr;
+
     Pole(const Vec3 &c, const Vec3 &o, const type &f, const type &l) :
             coordinates(c), orientation(o), frequency(f), length(l) {}
 
     std::vector<Wave>
     transmit(const type &power, const type &delay, const type &scaling_factor, const type &accuracy_factor) {
-        std::vector<Vec3> wave_directions;
-        for (const Vec3 &direction: nrcc::icosphere<type>(accuracy_factor)) {
-            wave_directions.emplace_back(direction);
-        }
+        return transmit(power, delay, scaling_factor, nrcc::icosphere<type>(accuracy_factor));
+    }
 
+    // Launches one wave along each given direction, for example from nrcc::fibonacci, stratified or sobol. The
+    // directions should cover equal solid angles, as power is shared by the antenna pattern alone.
+    std::vector<Wave>
+    transmit(const type &power, const type &delay, const type &scaling_factor, const std::vector<Vec3> &wave_directions) {
+        return transmit(power, delay, scaling_factor, wave_directions, 0, wave_directions.size());
+    }
+
+    // Only waves "first" to "last" of the launch above, each with the power it has there, so a launch can be split
+    // into slices without building the waves of the others.
+    std::vector<Wave>
+    transmit(const type &power, const type &delay, const type &scaling_factor, const std::vector<Vec3> &wave_directions,
+             const uint64_t &first, const uint64_t &last) {
         std::vector<type> wave_scales;
         for (const auto &direction: wave_directions) {
-            type s = pow(cross(direction, orientation).norm() / direction.norm() * orientation.norm(), scaling_factor);
+            type s = pattern != nullptr ? pattern->gain(direction) :
+                     pow(cross(direction, orientation).norm() / direction.norm() * orientation.norm(), scaling_factor);
             wave_scales.push_back(s);
         }
 
+        return launch(power, delay, wave_directions, wave_scales, first, last);
+    }
+
+    // Importance sampled launch from the pattern: "count" directions drawn where it radiates, each scaled by gain over
+    // sampling density so the launch carries the same power per solid angle as a uniform one. Without a pattern the
+    // dipole is launched along "count" stratified directions instead, with a scaling factor of 2.
+    std::vector<Wave> transmit(const type &power, const type &delay, const uint64_t &count, Rand &generator) {
+        if (pattern == nullptr) return transmit(power, delay, type(2), nrcc::stratified<type>(count, generator));
+
+        std::vector<Vec3> wave_directions;
+        std::vector<type> wave_scales;
+        for (uint64_t i = 0; i < count; i++) {
+            Vec3 direction = pattern->sample(generator);
+            wave_directions.push_back(direction);
+            wave_scales.push_back(pattern->gain(direction) / pattern->pdf(direction));
+        }
+
+        return launch(power, delay, wave_directions, wave_scales);
+    }
+
+    // Shares power over the waves in proportion to their scales, and builds waves "first" to "last" of them. Nothing is
+    // launched if no wave has a positive scale, as from an empty pattern.
+    std::vector<Wave> launch(const type &power, const type &delay, const std::vector<Vec3> &wave_directions,
+                             std::vector<type> wave_scales, const uint64_t &first = 0,
+                             const uint64_t &last = std::numeric_limits<uint64_t>::max()) {
         type magnitude = 0;
         for (const auto &scale: wave_scales) {
             magnitude += scale;
         }
+        if (!(magnitude > 0)) return {};
         for (auto &scale: wave_scales) {
             scale *= power / magnitude;
         }
 
         std::vector<Wave> waves;
-        for (uint64_t i = 0; i < wave_directions.size(); i++) {
-            waves.push_back({coordinates, wave_directions[i], wave_scales[i], frequency, delay, orientation.cmpx()});
+        for (uint64_t i = first; i < std::min<uint64_t>(last, wave_directions.size()); i++) {
+            VecC polar = pattern != nullptr ? pattern->polarization(wave_directions[i]) : orientation.cmpx();
+            waves.push_back({coordinates, wave_directions[i], frequency, wave_scales[i], delay, polar});
         }
 
         return waves;
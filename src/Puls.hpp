@@ -0,0 +1,301 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Time domain pulse responses. A receiver's channel is a set of paths, each with a delay and a complex field gain at
+// the carrier, and a pulse of limited bandwidth sent through it spreads into a sum of delayed copies. The response is
+// sampled around the carrier at "samples" frequency offsets f_k = (k - samples / 2) * rate / samples, weighted by the
+// spectrum of the pulse, and turned into "samples" time steps of 1 / rate by an inverse FFT. Delays beyond
+// samples / rate wrap around, so rate / samples should be finer than the inverse of the longest delay.
+//
+// Pulse spectra are normalized so that a lone path of gain g peaks at g. The gaussian pulse has its half power points
+// at +-bandwidth / 2, the raised cosine is flat over (1 - rolloff) * bandwidth and zero beyond (1 + rolloff) *
+// bandwidth, and the flat pulse keeps every offset within +-bandwidth / 2.
+//
+// Receivers are spread over "threads" worker threads. Within a receiver the data is kept as separate real and
+// imaginary arrays per field component: path phasors advance eight offsets at a time in independent lanes, and FFT
+// butterflies of a stage run over contiguous twiddles, so both inner loops vectorize. The FFT is radix 2 and needs no
+// external library. Offsets where the pulse spectrum is negligible are never accumulated, so a narrow pulse in a wide
+// sampled band costs in proportion to its bandwidth.
+//
+// "samples" must be a power of two of at least eight, and rate and bandwidth positive. Otherwise the pulse is rejected
+// with no samples, and every response comes out empty.
+
+#ifndef NARCCISSUS_PULS_HPP
+#define NARCCISSUS_PULS_HPP
+
+#include <atomic>
+#include <thread>
+#include "Taps.hpp"
+
+template<typename type>
+class Puls {
+    using cmpx = std::complex<type>;
+    using VecC = Vec3<cmpx>;
+    using Taps = Taps<type>;
+
+public:
+    enum Shape {
+        gaussian,
+        raised,
+        flat
+    };
+
+    struct Path {
+        type delay;
+        VecC gain;
+    };
+
+    // VARIABLES
+    uint64_t samples;
+    type rate;
+    type bandwidth;
+    Shape shape = gaussian;
+    type rolloff = 0.25;
+    uint64_t threads = std::max(1u, std::thread::hardware_concurrency());
+
+    // Per receiver, the field at each time step n / rate.
+    std::vector<std::vector<VecC>> responses;
+
+    // METHODS
+    type frequency(const uint64_t &k) const {
+        return (type(k) - type(samples / 2)) * rate / samples;
+    }
+
+    type time(const uint64_t &n) const {
+        return n / rate;
+    }
+
+    // Pulse spectrum at an offset from the carrier, before normalization.
+    type spectrum(const type &f) const {
+        type x = std::abs(f);
+        switch (shape) {
+            case gaussian:
+                return std::exp(-std::log(type(2)) * (2 * x / bandwidth) * (2 * x / bandwidth));
+            case raised: {
+                type low = (1 - rolloff) * bandwidth / 2;
+                type high = (1 + rolloff) * bandwidth / 2;
+                if (x <= low) return 1;
+                if (x >= high) return 0;
+                return (1 + std::cos(nrcc::pi * (x - low) / (high - low))) / 2;
+            }
+            case flat:
+                return x <= bandwidth / 2 ? 1 : 0;
+        }
+        return 0;
+    }
+
+    // Responses from the paths of each receiver.
+    void synthesize(const std::vector<std::vector<Path>> &paths) {
+        run(paths.size(), [&](const uint64_t &r, Buffer &buffer) {
+            buffer.clear();
+            for (const auto &path: paths[r]) accumulate(path, buffer);
+            finish(buffer, responses[r]);
+        });
+    }
+
+    // Responses from the delay bins of each accumulator, a path per bin at the bin centre.
+    void synthesize(const std::vector<Taps> &receivers) {
+        run(receivers.size(), [&](const uint64_t &r, Buffer &buffer) {
+            buffer.clear();
+            const Taps &receiver = receivers[r];
+            for (uint64_t bin = 0; bin < receiver.bins; bin++) {
+                const VecC &field = receiver.fields[bin];
+                if (field.x == cmpx(0) && field.y == cmpx(0) && field.z == cmpx(0)) continue;
+                accumulate({receiver.delay(bin), field}, buffer);
+            }
+            finish(buffer, responses[r]);
+        });
+    }
+
+    // Responses from frequency responses already sampled at frequency(k) for each receiver.
+    void transform(const std::vector<std::vector<VecC>> &spectra) {
+        run(spectra.size(), [&](const uint64_t &r, Buffer &buffer) {
+            for (uint64_t k = 0; k < samples; k++) {
+                for (int c = 0; c < 3; c++) {
+                    buffer.re[c][k] = spectra[r][k].v[c].real();
+                    buffer.im[c][k] = spectra[r][k].v[c].imag();
+                }
+            }
+            finish(buffer, responses[r]);
+        });
+    }
+
+    // Power of a response at each time step.
+    std::vector<type> envelope(const uint64_t &r) const {
+        std::vector<type> power(samples);
+        for (uint64_t n = 0; n < samples; n++) {
+            const VecC &e = responses[r][n];
+            power[n] = std::norm(e.x) + std::norm(e.y) + std::norm(e.z);
+        }
+        return power;
+    }
+
+    // In place inverse FFT of separate real and imaginary arrays, without the 1 / n factor.
+    void inverse(std::vector<type> &re, std::vector<type> &im) const {
+        for (uint64_t i = 0; i < samples; i++) {
+            if (i < reversed[i]) {
+                std::swap(re[i], re[reversed[i]]);
+                std::swap(im[i], im[reversed[i]]);
+            }
+        }
+
+        uint64_t offset = 0;
+        for (uint64_t half = 1; half < samples; offset += half, half *= 2) {
+            const type *wr = twiddle_re.data() + offset;
+            const type *wi = twiddle_im.data() + offset;
+            for (uint64_t start = 0; start < samples; start += 2 * half) {
+                type *ar = re.data() + start;
+                type *ai = im.data() + start;
+                type *br = ar + half;
+                type *bi = ai + half;
+                for (uint64_t j = 0; j < half; j++) {
+                    type tr = br[j] * wr[j] - bi[j] * wi[j];
+                    type ti = br[j] * wi[j] + bi[j] * wr[j];
+                    br[j] = ar[j] - tr;
+                    bi[j] = ai[j] - ti;
+                    ar[j] += tr;
+                    ai[j] += ti;
+                }
+            }
+        }
+    }
+
+    // CONSTRUCTORS
+    Puls(const uint64_t &samples, const type &rate, const type &bandwidth, const Shape &shape = gaussian) :
+            samples(samples), rate(rate), bandwidth(bandwidth), shape(shape) {
+        if (samples < 8 || (samples & (samples - 1)) != 0 || !(rate > 0) || !(bandwidth > 0)) {
+            std::cerr << "Error: Pulses need a power of two of at least 8 samples, and a positive rate and bandwidth\n";
+            this->samples = 0;
+            return;
+        }
+
+        reversed.resize(samples);
+        uint64_t bits = 0;
+        while ((uint64_t(1) << bits) < samples) bits++;
+        for (uint64_t i = 0; i < samples; i++) {
+            for (uint64_t b = 0; b < bits; b++) reversed[i] |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+
+        // Twiddles e^(+j pi j / half) for each stage, one after another.
+        for (uint64_t half = 1; half < samples; half *= 2) {
+            for (uint64_t j = 0; j < half; j++) {
+                twiddle_re.push_back(std::cos(nrcc::pi * j / half));
+                twiddle_im.push_back(std::sin(nrcc::pi * j / half));
+            }
+        }
+    }
+
+private:
+    static constexpr uint64_t lanes = 8;
+
+    struct Buffer {
+        std::array<std::vector<type>, 3> re;
+        std::array<std::vector<type>, 3> im;
+
+        void clear() {
+            for (int c = 0; c < 3; c++) {
+                std::fill(re[c].begin(), re[c].end(), 0);
+                std::fill(im[c].begin(), im[c].end(), 0);
+            }
+        }
+    };
+
+    static constexpr type negligible = 1e-15;
+
+    std::vector<uint64_t> reversed;
+    std::vector<type> twiddle_re;
+    std::vector<type> twiddle_im;
+
+    std::vector<type> weights;
+    uint64_t first = 0;
+    uint64_t last = 0;
+
+    template<typename F>
+    void run(const uint64_t &count, F &&work) {
+        responses.assign(count, std::vector<VecC>(samples));
+        if (samples == 0) return;
+
+        // Pulse weights, and the run of offsets where they are not negligible, rounded out to whole lanes.
+        type norm = 0;
+        weights.resize(samples);
+        for (uint64_t k = 0; k < samples; k++) norm += weights[k] = spectrum(frequency(k));
+        first = samples;
+        last = 0;
+        for (uint64_t k = 0; k < samples; k++) {
+            weights[k] /= norm;
+            if (weights[k] > negligible) {
+                first = std::min(first, k / lanes * lanes);
+                last = std::max(last, (k / lanes + 1) * lanes);
+            }
+        }
+
+        std::atomic<uint64_t> next = 0;
+        auto worker = [&] {
+            Buffer buffer;
+            for (int c = 0; c < 3; c++) {
+                buffer.re[c].assign(samples, 0);
+                buffer.im[c].assign(samples, 0);
+            }
+            for (uint64_t r = next++; r < count; r = next++) work(r, buffer);
+        };
+
+        std::vector<std::thread> workers;
+        for (uint64_t t = 1; t < std::min(threads, count); t++) workers.emplace_back(worker);
+        worker();
+        for (auto &thread: workers) thread.join();
+    }
+
+    // Adds the frequency response of one path, gain * e^(-j 2 pi f_k delay), lanes offsets at a time. Offsets the pulse
+    // leaves out are skipped.
+    void accumulate(const Path &path, Buffer &buffer) const {
+        type pr[lanes];
+        type qi[lanes];
+        for (uint64_t l = 0; l < lanes; l++) {
+            type phase = -2 * nrcc::pi * frequency(first + l) * path.delay;
+            pr[l] = std::cos(phase);
+            qi[l] = std::sin(phase);
+        }
+        type step = -2 * nrcc::pi * lanes * rate / samples * path.delay;
+        type sr = std::cos(step);
+        type si = std::sin(step);
+
+        std::array<type, 3> gr = {path.gain.x.real(), path.gain.y.real(), path.gain.z.real()};
+        std::array<type, 3> gi = {path.gain.x.imag(), path.gain.y.imag(), path.gain.z.imag()};
+
+        for (uint64_t k = first; k < last; k += lanes) {
+            for (int c = 0; c < 3; c++) {
+                type *re = buffer.re[c].data() + k;
+                type *im = buffer.im[c].data() + k;
+                for (uint64_t l = 0; l < lanes; l++) {
+                    re[l] += gr[c] * pr[l] - gi[c] * qi[l];
+                    im[l] += gr[c] * qi[l] + gi[c] * pr[l];
+                }
+            }
+            for (uint64_t l = 0; l < lanes; l++) {
+                type r = pr[l] * sr - qi[l] * si;
+                qi[l] = pr[l] * si + qi[l] * sr;
+                pr[l] = r;
+            }
+        }
+    }
+
+    // Weights the sampled response by the pulse, transforms it and shifts it back from offsets to the carrier.
+    void finish(Buffer &buffer, std::vector<VecC> &response) const {
+        for (int c = 0; c < 3; c++) {
+            for (uint64_t k = 0; k < samples; k++) {
+                buffer.re[c][k] *= weights[k];
+                buffer.im[c][k] *= weights[k];
+            }
+            inverse(buffer.re[c], buffer.im[c]);
+        }
+
+        // Offsets start at -samples / 2, which multiplies step n by (-1)^n.
+        for (uint64_t n = 0; n < samples; n++) {
+            type sign = n % 2 == 1 ? -1 : 1;
+            response[n] = {cmpx(buffer.re[0][n], buffer.im[0][n]) * sign,
+                           cmpx(buffer.re[1][n], buffer.im[1][n]) * sign,
+                           cmpx(buffer.re[2][n], buffer.im[2][n]) * sign};
+        }
+    }
+};
+
+#endif //NARCCISSUS_PULS_HPP
@@ -0,0 +1,54 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Counter based random numbers. Every draw is a hash of a key and a counter (the SplitMix64 finalizer), so a generator
+// is two integers, costs a few multiplies per draw and any stream can be reproduced or skipped ahead without running
+// it. Parallel code should give each work item its own stream, for example Rand{seed, ray index}, which makes results
+// independent of how items are scheduled onto threads.
+//
+// Rand::local() is a per-thread generator for code that has no natural stream index. Its streams follow the order in
+// which threads first draw from it, starting from Rand::seed.
+
+#ifndef NARCCISSUS_RAND_HPP
+#define NARCCISSUS_RAND_HPP
+
+#include <atomic>
+#include <cstdint>
+
+struct Rand {
+    static inline std::atomic<uint64_t> seed = 0x6E72636369737573;
+
+    // VARIABLES
+    uint64_t key;
+    uint64_t counter = 0;
+
+    // METHODS
+    uint64_t next() {
+        return mix(key + 0x9E3779B97F4A7C15 * ++counter);
+    }
+
+    // Uniform on [0, 1) with the full 53 bits of a double.
+    double uniform() {
+        return (next() >> 11) * 0x1.0p-53;
+    }
+
+    void skip(const uint64_t &n) {
+        counter += n;
+    }
+
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+        return z ^ (z >> 31);
+    }
+
+    static Rand &local() {
+        static std::atomic<uint64_t> threads = 0;
+        thread_local Rand generator{seed.load(), threads++};
+        return generator;
+    }
+
+    // CONSTRUCTORS
+    Rand(const uint64_t &seed, const uint64_t &stream = 0) : key(mix(seed ^ mix(stream + 1))) {}
+};
+
+#endif //NARCCISSUS_RAND_HPP
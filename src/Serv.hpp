@@ -0,0 +1,341 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Long lived simulation server. Scenes are loaded once by name and kept resident with their trees, and queries against
+// them run on a shared pool of worker threads, so a query costs its trace and nothing else. Requests arrive on any pair
+// of file descriptors: stdin and stdout for a child process, or the connections of a local Unix socket.
+//
+// Every message is a header followed by "length" bytes of body. Numbers are in native byte order, strings are a uint64
+// length and the characters, and real values are written as the template type.
+//
+//   header     magic (uint32), op or status (uint32), id (uint64), length (uint64)
+//
+//   load       name, OBJ path relative to "root"                               -> empty
+//   drop       name                                                            -> empty
+//   query      name, tx coordinates (3), orientation (3), frequency, power,   -> receiver count (uint64), then each
+//              accuracy (uint64), depth (uint8), resolution, bins (uint64),       receiver as written by Taps::write
+//              receiver count (uint64), then per receiver coordinates (3)
+//              and radius
+//
+// Responses carry the id of their request and are written as soon as they complete, so they may come back out of
+// order. A client should wait for a load to succeed before querying the scene. A connection is served until its input
+// ends, and its remaining responses are written before serve() returns. A body longer than "limit" is answered with
+// failed and ends the connection, as its bytes are never read.
+//
+// Requests are untrusted. A load of a path that leads outside "root" fails, as does a query asking for a launch
+// accuracy, depth, receiver count or total number of delay bins over the configured maxima, which is checked before
+// anything is allocated or traced.
+//
+// Only POSIX systems are supported. serve() ignores SIGPIPE for the whole process, so a client that goes away makes
+// writes fail instead of killing the server.
+
+#ifndef NARCCISSUS_SERV_HPP
+#define NARCCISSUS_SERV_HPP
+
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <functional>
+#include <deque>
+#include <memory>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "Mesh.hpp"
+#include "Nrcc.hpp"
+#include "Pole.hpp"
+#include "Taps.hpp"
+
+template<typename type>
+class Serv {
+    using Vec3 = Vec3<type>;
+    using Wave = Wave<type>;
+    using Pole = Pole<type>;
+    using Taps = Taps<type>;
+    using Mesh = Mesh<type>;
+
+public:
+    enum Op : uint32_t {
+        load = 1,
+        drop = 2,
+        query = 3,
+    };
+
+    enum Status : uint32_t {
+        ok = 0,
+        failed = 1,
+    };
+
+    struct Header {
+        uint32_t magic;
+        uint32_t op;
+        uint64_t id;
+        uint64_t length;
+    };
+
+    static constexpr uint32_t magic = 0x4E525356;
+
+    // VARIABLES
+    // Largest request body accepted, in bytes.
+    uint64_t limit = 1 << 26;
+
+    // Largest query accepted: icosphere accuracy, reflection depth, receivers, and delay bins over all receivers.
+    uint64_t max_accuracy = 6;
+    uint8_t max_depth = 6;
+    uint64_t max_receivers = 1024;
+    uint64_t max_bins = 1 << 22;
+
+    // Directory that load paths are resolved in.
+    std::filesystem::path root = ".";
+
+    // METHODS
+    // Serves requests read from "in" until it ends, writing responses to "out".
+    void serve(const int &in, const int &out) {
+        std::signal(SIGPIPE, SIG_IGN);
+        auto connection = std::make_shared<Connection>(out);
+
+        Header header;
+        while (receive(in, &header, sizeof(header)) && header.magic == magic) {
+            {
+                std::lock_guard lock(connection->mutex);
+                connection->pending++;
+            }
+
+            if (header.length > limit) {
+                connection->respond({magic, failed, header.id, 0}, "");
+                break;
+            }
+
+            auto body = std::make_shared<std::string>(header.length, '\0');
+            if (!receive(in, body->data(), body->size())) {
+                connection->respond({magic, failed, header.id, 0}, "");
+                break;
+            }
+
+            submit([this, connection, header, body] {
+                std::string response;
+                Status status = failed;
+                try {
+                    status = handle(header.op, *body, response);
+                } catch (const std::exception &) {
+                    response.clear();
+                }
+                connection->respond({magic, status, header.id, response.size()}, response);
+            });
+        }
+
+        std::unique_lock lock(connection->mutex);
+        connection->done.wait(lock, [&] { return connection->pending == 0; });
+    }
+
+    // Accepts connections on a Unix socket at "path" and serves each on its own thread. Does not return unless the
+    // socket cannot be set up.
+    void listen(const std::string &path) {
+        int server = socket(AF_UNIX, SOCK_STREAM, 0);
+
+        sockaddr_un address = {};
+        address.sun_family = AF_UNIX;
+        path.copy(address.sun_path, sizeof(address.sun_path) - 1);
+        unlink(path.c_str());
+
+        if (server < 0 || bind(server, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 ||
+            ::listen(server, 16) < 0) {
+            std::cerr << "Error: Could not listen on " << path << "\n";
+            return;
+        }
+
+        while (true) {
+            int client = accept(server, nullptr, nullptr);
+            if (client < 0) continue;
+
+            std::thread([this, client] {
+                serve(client, client);
+                close(client);
+            }).detach();
+        }
+    }
+
+    // CONSTRUCTORS
+    explicit Serv(const uint64_t &threads = std::max(1u, std::thread::hardware_concurrency())) {
+        for (uint64_t i = 0; i < threads; i++) {
+            workers.emplace_back([this] {
+                while (true) {
+                    std::function<void()> job;
+                    {
+                        std::unique_lock lock(mutex);
+                        wake.wait(lock, [&] { return stopping || !jobs.empty(); });
+                        if (jobs.empty()) return;
+                        job = std::move(jobs.front());
+                        jobs.pop_front();
+                    }
+                    job();
+                }
+            });
+        }
+    }
+
+    ~Serv() {
+        {
+            std::lock_guard lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto &worker: workers) worker.join();
+    }
+
+private:
+    struct Connection {
+        int out;
+        std::mutex mutex;
+        std::condition_variable done;
+        uint64_t pending = 0;
+
+        void respond(const Header &header, const std::string &body) {
+            std::lock_guard lock(mutex);
+            send(out, &header, sizeof(header));
+            send(out, body.data(), body.size());
+            if (--pending == 0) done.notify_all();
+        }
+
+        explicit Connection(const int &out) : out(out) {}
+    };
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    std::shared_mutex scenes_mutex;
+    std::map<std::string, std::shared_ptr<Mesh>> scenes;
+
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+
+    Status handle(const uint32_t &op, const std::string &bytes, std::string &response) {
+        std::istringstream body(bytes);
+        auto get = [&](auto &value) { body.read(reinterpret_cast<char *>(&value), sizeof(value)); };
+        auto text = [&]() {
+            uint64_t n = 0;
+            get(n);
+            std::string s(std::min<uint64_t>(n, bytes.size()), '\0');
+            body.read(s.data(), s.size());
+            return s;
+        };
+        auto vec = [&]() {
+            Vec3 v;
+            get(v.x);
+            get(v.y);
+            get(v.z);
+            return v;
+        };
+
+        std::string name = text();
+
+        if (op == load) {
+            std::string file = text();
+            if (!body) return failed;
+
+            std::error_code error;
+            std::filesystem::path base = std::filesystem::canonical(root, error);
+            if (error) return failed;
+            std::filesystem::path path = std::filesystem::weakly_canonical(base / file, error);
+            if (error || std::mismatch(base.begin(), base.end(), path.begin(), path.end()).first != base.end()) {
+                return failed;
+            }
+
+            std::ifstream obj(path);
+            if (!obj) return failed;
+
+            auto mesh = std::make_shared<Mesh>(read<type>(std::move(obj)));
+            std::unique_lock lock(scenes_mutex);
+            scenes[name] = mesh;
+            return ok;
+        }
+
+        if (op == drop) {
+            std::unique_lock lock(scenes_mutex);
+            return scenes.erase(name) ? ok : failed;
+        }
+
+        if (op != query) return failed;
+
+        std::shared_ptr<Mesh> mesh;
+        {
+            std::shared_lock lock(scenes_mutex);
+            auto found = scenes.find(name);
+            if (found == scenes.end()) return failed;
+            mesh = found->second;
+        }
+
+        Vec3 coordinates = vec();
+        Vec3 orientation = vec();
+        type frequency, power, resolution;
+        uint64_t accuracy, bins, count;
+        uint8_t depth;
+        get(frequency);
+        get(power);
+        get(accuracy);
+        get(depth);
+        get(resolution);
+        get(bins);
+        get(count);
+        if (!body || accuracy > max_accuracy || depth > max_depth || count > max_receivers || bins > max_bins ||
+            bins * count > max_bins || !(resolution > 0)) {
+            return failed;
+        }
+
+        std::vector<Taps> receivers;
+        for (uint64_t i = 0; i < count && body; i++) {
+            Vec3 position = vec();
+            type radius;
+            get(radius);
+            receivers.push_back({{position, orientation, frequency, radius}, resolution, bins});
+        }
+        if (!body) return failed;
+
+        Pole transmitter = {coordinates, orientation, frequency, 1};
+        Nrcc<type> tracer;
+        for (Wave &wave: transmitter.transmit(power, 0, 2, accuracy)) tracer.trace(wave, *mesh, receivers, depth);
+
+        std::ostringstream out;
+        uint64_t n = receivers.size();
+        out.write(reinterpret_cast<const char *>(&n), sizeof(n));
+        for (const auto &receiver: receivers) receiver.write(out);
+        response = out.str();
+        return ok;
+    }
+
+    static bool receive(const int &fd, void *data, uint64_t size) {
+        char *p = static_cast<char *>(data);
+        while (size > 0) {
+            ssize_t n = ::read(fd, p, size);
+            if (n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+
+    static bool send(const int &fd, const void *data, uint64_t size) {
+        const char *p = static_cast<const char *>(data);
+        while (size > 0) {
+            ssize_t n = ::write(fd, p, size);
+            if (n <= 0) return false;
+            p += n;
+            size -= n;
+        }
+        return true;
+    }
+};
+
+#endif //NARCCISSUS_SERV_HPP
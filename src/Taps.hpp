@@ -0,0 +1,331 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Channel accumulator for one receiver. Every wave that passes through the reception sphere during a trace is added as
+// it is found, binned by delay (path length over lightspeed), angle of arrival and angle of departure. Individual waves
+// are never stored, so memory per receiver is fixed by the configuration rather than by the ray count:
+//
+// - "bins" delay bins of width "resolution" each hold the coherent field and the incoherent power, from which the
+//   power delay profile and RMS delay spread are derived.
+// - Up to "capacity" taps split each delay bin further by arrival and departure sector, on a grid of "sectors" azimuth
+//   by sectors / 2 elevation cells. Contributions to new taps beyond capacity are still counted in the delay bins.
+//   A tap whose contributions are all taken back is freed for new ones.
+//
+// Contributions arriving after the last delay bin only add to "late".
+//
+// Accumulators with the same configuration can be written out, read back and merged, so partial traces of the same
+// receiver (for example from separate processes) combine into one.
+
+#ifndef NARCCISSUS_TAPS_HPP
+#define NARCCISSUS_TAPS_HPP
+
+#include <unordered_map>
+#include "Wave.hpp"
+#include "Pole.hpp"
+
+template<typename type>
+class Taps {
+    using cmpx = std::complex<type>;
+    using VecC = Vec3<cmpx>;
+    using Vec3 = Vec3<type>;
+    using Wave = Wave<type>;
+    using Pole = Pole<type>;
+
+public:
+    struct Tap {
+        uint64_t delay;
+        uint64_t arrival;
+        uint64_t departure;
+        VecC field;
+        type power;
+        uint64_t count;
+    };
+
+    // VARIABLES
+    Pole pole;
+    type resolution;
+    uint64_t bins;
+    uint64_t sectors;
+    uint64_t capacity;
+
+    std::vector<VecC> fields;
+    std::vector<type> powers;
+    std::vector<Tap> taps;
+
+    uint64_t count = 0;
+    uint64_t dropped = 0;
+    type late = 0;
+
+    // METHODS
+    // Adds a wave if it passes through the reception sphere before limit, the distance to its next interaction.
+    void receive(Wave &wave, const type &limit) {
+        type d = nrcc::intersectionDistance(wave.origin, wave.direct, pole.coordinates, pole.length);
+        if (d <= 0 || d >= limit) return;
+
+        type r = range(wave.origin, pole.coordinates);
+
+        type length = r;
+        Wave *root = &wave;
+        while (root->genesis.wave != nullptr) {
+            length += root->genesis.distance;
+            root = root->genesis.wave;
+        }
+
+        add(wave.electricField(r), length, wave.direct * -1, root->direct);
+    }
+
+    // Adds a contribution. Returns whether it went into a tap, rather than being late or dropped.
+    bool add(const VecC &field, const type &length, const Vec3 &arrival, const Vec3 &departure) {
+        type power = std::norm(field.x) + std::norm(field.y) + std::norm(field.z);
+
+        uint64_t bin = length / nrcc::lightspeed / resolution;
+        if (bin >= bins) {
+            late += power;
+            return false;
+        }
+
+        count++;
+        fields[bin] = fields[bin] + field;
+        powers[bin] += power;
+
+        uint64_t cells = sectors * (sectors / 2);
+        uint64_t key = (bin * cells + sector(arrival)) * cells + sector(departure);
+
+        auto found = index.find(key);
+        if (found != index.end()) {
+            Tap &tap = taps[found->second];
+            tap.field = tap.field + field;
+            tap.power += power;
+            tap.count++;
+        }
+        else if (taps.size() < capacity) {
+            index[key] = taps.size();
+            taps.push_back({bin, sector(arrival), sector(departure), field, power, 1});
+        }
+        else {
+            dropped++;
+            return false;
+        }
+        return true;
+    }
+
+    // Takes back a contribution made by add() with the same arguments, given what add() returned for it. The last
+    // contribution taken from a tap frees it, as though it had never been added.
+    void remove(const VecC &field, const type &length, const Vec3 &arrival, const Vec3 &departure, const bool &kept) {
+        type power = std::norm(field.x) + std::norm(field.y) + std::norm(field.z);
+
+        uint64_t bin = length / nrcc::lightspeed / resolution;
+        if (bin >= bins) {
+            late -= power;
+            return;
+        }
+
+        count--;
+        fields[bin] = fields[bin] - field;
+        powers[bin] -= power;
+
+        uint64_t cells = sectors * (sectors / 2);
+        uint64_t key = (bin * cells + sector(arrival)) * cells + sector(departure);
+
+        auto found = index.find(key);
+        if (!kept || found == index.end()) {
+            dropped--;
+            return;
+        }
+
+        uint64_t t = found->second;
+        taps[t].field = taps[t].field - field;
+        taps[t].power -= power;
+        if (--taps[t].count > 0) return;
+
+        // Moves the last tap into the freed slot.
+        index.erase(found);
+        if (t + 1 < taps.size()) {
+            taps[t] = taps.back();
+            index[(taps[t].delay * cells + taps[t].arrival) * cells + taps[t].departure] = t;
+        }
+        taps.pop_back();
+    }
+
+    // Sum of every contribution, the same quantity Pole::receive returns as a real vector.
+    VecC field() const {
+        VecC total = {0, 0, 0};
+        for (const auto &f: fields) total = total + f;
+        return total;
+    }
+
+    type delay(const uint64_t &bin) const {
+        return (bin + 0.5) * resolution;
+    }
+
+    std::vector<type> pdp() const {
+        return powers;
+    }
+
+    type meanDelay() const {
+        type p = 0;
+        type t = 0;
+        for (uint64_t i = 0; i < bins; i++) {
+            p += powers[i];
+            t += powers[i] * delay(i);
+        }
+        return p > 0 ? t / p : 0;
+    }
+
+    type delaySpread() const {
+        type p = 0;
+        type t = 0;
+        type t2 = 0;
+        for (uint64_t i = 0; i < bins; i++) {
+            p += powers[i];
+            t += powers[i] * delay(i);
+            t2 += powers[i] * delay(i) * delay(i);
+        }
+        if (p <= 0) return 0;
+
+        type mean = t / p;
+        return std::sqrt(std::max(type(0), t2 / p - mean * mean));
+    }
+
+    // Azimuth and elevation cell of a direction.
+    uint64_t sector(const Vec3 &direct) const {
+        type az = (direct.AZ() + nrcc::pi) / (2 * nrcc::pi);
+        type el = (direct.EL() + nrcc::pi / 2) / nrcc::pi;
+
+        uint64_t a = std::min<uint64_t>(az * sectors, sectors - 1);
+        uint64_t e = std::min<uint64_t>(el * (sectors / 2), sectors / 2 - 1);
+        return e * sectors + a;
+    }
+
+    // Adds another accumulator of the same configuration. Taps are merged in the other's insertion order, so merging
+    // the same partials in the same order always gives the same result.
+    void merge(const Taps &other) {
+        for (uint64_t i = 0; i < bins; i++) {
+            fields[i] = fields[i] + other.fields[i];
+            powers[i] += other.powers[i];
+        }
+
+        uint64_t cells = sectors * (sectors / 2);
+        for (const auto &tap: other.taps) {
+            uint64_t key = (tap.delay * cells + tap.arrival) * cells + tap.departure;
+
+            auto found = index.find(key);
+            if (found != index.end()) {
+                taps[found->second].field = taps[found->second].field + tap.field;
+                taps[found->second].power += tap.power;
+                taps[found->second].count += tap.count;
+            }
+            else if (taps.size() < capacity) {
+                index[key] = taps.size();
+                taps.push_back(tap);
+            }
+            else dropped += tap.count;
+        }
+
+        count += other.count;
+        dropped += other.dropped;
+        late += other.late;
+    }
+
+    void write(std::ostream &os) const {
+        auto put = [&](const auto &value) { os.write(reinterpret_cast<const char *>(&value), sizeof(value)); };
+
+        put(bins);
+        put(sectors);
+        put(resolution);
+        put(capacity);
+        put(count);
+        put(dropped);
+        put(late);
+        for (uint64_t i = 0; i < bins; i++) {
+            put(fields[i].x);
+            put(fields[i].y);
+            put(fields[i].z);
+            put(powers[i]);
+        }
+        put(static_cast<uint64_t>(taps.size()));
+        for (const auto &tap: taps) {
+            put(tap.delay);
+            put(tap.arrival);
+            put(tap.departure);
+            put(tap.field.x);
+            put(tap.field.y);
+            put(tap.field.z);
+            put(tap.power);
+            put(tap.count);
+        }
+    }
+
+    // Reads an accumulator written by write() over this one. Returns false if the stream ends early, was written with
+    // a different bin count, sector count, resolution or capacity, or holds more taps than the capacity.
+    bool read(std::istream &is) {
+        auto get = [&](auto &value) { is.read(reinterpret_cast<char *>(&value), sizeof(value)); };
+
+        clear();
+
+        uint64_t b;
+        uint64_t s;
+        type r;
+        uint64_t c;
+        get(b);
+        get(s);
+        get(r);
+        get(c);
+        if (!is || b != bins || s != sectors || r != resolution || c != capacity) return false;
+
+        get(count);
+        get(dropped);
+        get(late);
+        for (uint64_t i = 0; i < bins; i++) {
+            get(fields[i].x);
+            get(fields[i].y);
+            get(fields[i].z);
+            get(powers[i]);
+        }
+
+        uint64_t n;
+        get(n);
+        if (!is || n > capacity) return false;
+        for (uint64_t i = 0; i < n && is; i++) {
+            Tap tap;
+            get(tap.delay);
+            get(tap.arrival);
+            get(tap.departure);
+            get(tap.field.x);
+            get(tap.field.y);
+            get(tap.field.z);
+            get(tap.power);
+            get(tap.count);
+
+            uint64_t cells = sectors * (sectors / 2);
+            index[(tap.delay * cells + tap.arrival) * cells + tap.departure] = taps.size();
+            taps.push_back(tap);
+        }
+        return static_cast<bool>(is);
+    }
+
+    void clear() {
+        std::fill(fields.begin(), fields.end(), VecC{0, 0, 0});
+        std::fill(powers.begin(), powers.end(), 0);
+        taps.clear();
+        index.clear();
+        count = 0;
+        dropped = 0;
+        late = 0;
+    }
+
+    // CONSTRUCTORS
+    Taps(const Pole &pole, const type &resolution, const uint64_t &bins, const uint64_t &sectors = 8,
+         const uint64_t &capacity = 256) :
+            pole(pole),
+            resolution(resolution),
+            bins(bins),
+            sectors(sectors),
+            capacity(capacity),
+            fields(bins, VecC{0, 0, 0}),
+            powers(bins, 0) {}
+
+private:
+    std::unordered_map<uint64_t, uint64_t> index;
+};
+
+#endif //NARCCISSUS_TAPS_HPP
@@ -0,0 +1,336 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Out of core scenes. write() partitions a face set into square columns of "cell" metres over the ground plane (x, z)
+// and stores each column as its own file next to an index of column boxes:
+//
+//   index.bin      magic, tile count, then per tile its box (6) and face count
+//   tile_<i>.bin   magic, face count, then per face its material (uint32), corner count (uint64) and corners (3 each)
+//
+// A face belongs to the column holding its centroid, and the column box grows to cover it, so boxes may overlap. Only
+// the index and the small tree over it stay resident. Tiles are read and given their own mesh when rays first need
+// them, and the least recently used ones are dropped whenever the resident tiles exceed "budget" bytes. The tile in
+// use is always kept, so a budget below one tile still works, one tile at a time.
+//
+// Tracing is deferred and batched per tile. Every ray lists the tiles its line enters, nearest first, and waits in the
+// queue of the first one. The busiest queue is drained next, preferring tiles already resident, so a tile is read once
+// for many rays instead of once per ray. A ray moves on to its next tile only if that tile starts before its closest hit
+// so far, as boxes are visited in order of entry. Resolved rays are offered to the receivers and spawn their reflected
+// and refracted waves into the queues, which gives the same waves and receptions as Nrcc's streaming trace. Launched
+// waves are taken "batch" at a time, so memory is bounded by the budget plus the waves of one batch whatever the size
+// of the map.
+
+#ifndef NARCCISSUS_TILE_HPP
+#define NARCCISSUS_TILE_HPP
+
+#include <fstream>
+#include <list>
+#include <deque>
+#include <memory>
+#include <optional>
+#include "Mesh.hpp"
+#include "Nrcc.hpp"
+#include "Taps.hpp"
+
+template<typename type>
+class Tile {
+    using Vec3 = Vec3<type>;
+    using Face = Face<type>;
+    using Wave = Wave<type>;
+    using Taps = Taps<type>;
+    using Mesh = Mesh<type>;
+    using Tree = Tree<type>;
+    using Box = std::array<Vec3, 2>;
+
+public:
+    // VARIABLES
+    std::string directory;
+    std::vector<Box> boxes;
+    std::vector<uint64_t> counts;
+    Tree top;
+
+    uint64_t budget;
+    uint64_t batch = 4096;
+
+    // Statistics: tiles read from disk, rays tested against a tile, resident bytes now and at most.
+    uint64_t loads = 0;
+    uint64_t visits = 0;
+    uint64_t resident = 0;
+    uint64_t peak = 0;
+
+    static constexpr uint32_t magic = 0x4E52544C;
+
+    // METHODS
+    static bool write(const std::string &directory, const std::vector<Face> &faces, const type &cell) {
+        std::map<std::pair<int64_t, int64_t>, std::vector<const Face *>> columns;
+        for (const auto &face: faces) {
+            Vec3 c = {0, 0, 0};
+            std::vector<Vec3> corners = face.corners();
+            for (const auto &p: corners) c = c + p;
+            c = c / type(corners.size());
+            columns[{static_cast<int64_t>(std::floor(c.x / cell)), static_cast<int64_t>(std::floor(c.z / cell))}]
+                    .push_back(&face);
+        }
+
+        std::ofstream index(directory + "/index.bin", std::ofstream::binary);
+        auto put = [](std::ofstream &out, const auto &value) {
+            out.write(reinterpret_cast<const char *>(&value), sizeof(value));
+        };
+
+        put(index, magic);
+        put(index, static_cast<uint64_t>(columns.size()));
+
+        uint64_t t = 0;
+        for (const auto &[key, column]: columns) {
+            std::ofstream out(directory + "/tile_" + std::to_string(t++) + ".bin", std::ofstream::binary);
+            put(out, magic);
+            put(out, static_cast<uint64_t>(column.size()));
+
+            Box box = column[0]->box();
+            for (const Face *face: column) {
+                std::vector<Vec3> corners = face->corners();
+                put(out, static_cast<uint32_t>(face->material));
+                put(out, static_cast<uint64_t>(corners.size()));
+                for (const auto &p: corners) {
+                    put(out, p.x);
+                    put(out, p.y);
+                    put(out, p.z);
+                }
+                box = Tree::merge(box, face->box());
+            }
+            if (!out) return false;
+
+            for (const auto &corner: box) {
+                put(index, corner.x);
+                put(index, corner.y);
+                put(index, corner.z);
+            }
+            put(index, static_cast<uint64_t>(column.size()));
+        }
+        return static_cast<bool>(index);
+    }
+
+    uint64_t size() const {
+        return boxes.size();
+    }
+
+    // Mesh of a tile, read if it is not resident. Reading may drop other tiles, invalidating their references.
+    const Mesh &mesh(const uint64_t &tile) {
+        auto found = cache.find(tile);
+        if (found != cache.end()) {
+            recent.splice(recent.begin(), recent, found->second.position);
+            return *found->second.mesh;
+        }
+
+        auto mesh = std::make_unique<Mesh>(read(tile));
+        uint64_t bytes = footprint(*mesh);
+
+        while (!recent.empty() && resident + bytes > budget) {
+            auto evicted = cache.find(recent.back());
+            resident -= evicted->second.bytes;
+            cache.erase(evicted);
+            recent.pop_back();
+        }
+
+        recent.push_front(tile);
+        resident += bytes;
+        peak = std::max(peak, resident);
+        loads++;
+
+        return *cache.emplace(tile, Cached{std::move(mesh), bytes, recent.begin()}).first->second.mesh;
+    }
+
+    bool cached(const uint64_t &tile) const {
+        return cache.count(tile) > 0;
+    }
+
+    void trace(std::vector<Wave> &waves, std::vector<Taps> &receivers, const uint8_t &rs) {
+        for (uint64_t first = 0; first < waves.size(); first += batch) {
+            Batch work{*this, receivers};
+            for (uint64_t i = first; i < std::min<uint64_t>(waves.size(), first + batch); i++) work.start(waves[i], rs);
+            work.run();
+        }
+    }
+
+    // CONSTRUCTORS
+    Tile(const std::string &directory, const uint64_t &budget) : directory(directory), budget(budget) {
+        std::ifstream index(directory + "/index.bin", std::ifstream::binary);
+        auto get = [&](auto &value) { index.read(reinterpret_cast<char *>(&value), sizeof(value)); };
+
+        uint32_t m = 0;
+        uint64_t n = 0;
+        get(m);
+        get(n);
+        if (m != magic) {
+            std::cerr << "Error: " << directory << " is not a tiled scene\n";
+            return;
+        }
+
+        for (uint64_t t = 0; t < n && index; t++) {
+            Box box;
+            for (auto &corner: box) {
+                get(corner.x);
+                get(corner.y);
+                get(corner.z);
+            }
+            uint64_t count;
+            get(count);
+            boxes.push_back(box);
+            counts.push_back(count);
+        }
+
+        top.leaf_size = 1;
+        top.build(boxes);
+    }
+
+private:
+    struct Cached {
+        std::unique_ptr<Mesh> mesh;
+        uint64_t bytes;
+        std::list<uint64_t>::iterator position;
+    };
+
+    std::map<uint64_t, Cached> cache;
+    std::list<uint64_t> recent;
+
+    // A ray waiting on its tiles. Its closest face so far is copied, with the corners of a polygon, as the tile holding
+    // it may be dropped.
+    struct Ray {
+        Wave *wave;
+        uint8_t rs;
+        std::vector<std::pair<type, uint64_t>> tiles;
+        uint64_t next;
+        type distance;
+        std::optional<Face> face;
+        std::vector<Vec3> outline;
+    };
+
+    struct Batch {
+        Tile &scene;
+        std::vector<Taps> &receivers;
+        Nrcc<type> tracer;
+
+        // Deques keep child waves and the faces they point to in place as more are added.
+        std::deque<Wave> waves;
+        std::deque<Face> faces;
+        std::vector<Ray> rays;
+        std::map<uint64_t, std::vector<uint64_t>> queues;
+
+        void start(Wave &wave, const uint8_t &rs) {
+            Ray ray = {&wave, rs, {}, 0, nrcc::infinity, std::nullopt, {}};
+
+            Vec3 inverse = {1 / wave.direct.x, 1 / wave.direct.y, 1 / wave.direct.z};
+            scene.top.traverse(wave.origin, wave.direct, nrcc::infinity, [&](const uint64_t &t, type &) {
+                ray.tiles.push_back({Tree::entry(scene.boxes[t], wave.origin, inverse), t});
+                return false;
+            });
+            std::sort(ray.tiles.begin(), ray.tiles.end());
+
+            rays.push_back(ray);
+            advance(rays.size() - 1);
+        }
+
+        // Queues a ray on its next tile, or resolves it once no tile left can hold a closer hit.
+        void advance(const uint64_t &r) {
+            Ray &ray = rays[r];
+            if (ray.next < ray.tiles.size() && ray.tiles[ray.next].first < ray.distance) {
+                queues[ray.tiles[ray.next++].second].push_back(r);
+                return;
+            }
+
+            Wave &wave = *ray.wave;
+            for (auto &receiver: receivers) receiver.receive(wave, ray.distance);
+            if (!ray.face || ray.rs == 0) return;
+
+            Face &face = faces.emplace_back(*ray.face);
+            uint8_t rs = ray.rs - 1;
+            start(waves.emplace_back(tracer.reflectedWave(wave, face)), rs);
+            start(waves.emplace_back(tracer.refractedWave(wave, face)), rs);
+        }
+
+        void run() {
+            while (!queues.empty()) {
+                auto busiest = queues.begin();
+                for (auto q = queues.begin(); q != queues.end(); q++) {
+                    bool resident = scene.cached(q->first);
+                    bool best = scene.cached(busiest->first);
+                    if (resident > best || (resident == best && q->second.size() > busiest->second.size())) busiest = q;
+                }
+
+                uint64_t tile = busiest->first;
+                const Mesh &mesh = scene.mesh(tile);
+
+                // Rays resolved here may queue their children on this same tile, so drain until it stays empty.
+                while (queues.count(tile)) {
+                    std::vector<uint64_t> queue = std::move(queues[tile]);
+                    queues.erase(tile);
+                    scene.visits += queue.size();
+
+                    for (const auto &r: queue) {
+                        Ray &ray = rays[r];
+                        typename Mesh::Hit hit = mesh.intersect(ray.wave->origin, ray.wave->direct, ray.distance);
+                        if (hit.distance < ray.distance) {
+                            ray.distance = hit.distance;
+                            ray.face = mesh.groups[hit.group].faces[hit.index];
+                            if (ray.face->outline != nullptr) {
+                                ray.outline.assign(ray.face->outline, ray.face->outline + ray.face->sides);
+                                ray.face->outline = ray.outline.data();
+                            }
+                        }
+                        advance(r);
+                    }
+                }
+            }
+        }
+
+        Batch(Tile &scene, std::vector<Taps> &receivers) : scene(scene), receivers(receivers) {}
+    };
+
+    Mesh read(const uint64_t &tile) const {
+        std::ifstream in(directory + "/tile_" + std::to_string(tile) + ".bin", std::ifstream::binary);
+        auto get = [&](auto &value) { in.read(reinterpret_cast<char *>(&value), sizeof(value)); };
+
+        uint32_t m = 0;
+        uint64_t n = 0;
+        get(m);
+        get(n);
+
+        // Polygon corners only need to last until the mesh copies them.
+        std::vector<Face> faces;
+        std::vector<std::vector<Vec3>> polygons;
+        for (uint64_t f = 0; f < n && m == magic && in; f++) {
+            uint32_t material;
+            uint64_t count;
+            get(material);
+            get(count);
+
+            std::vector<Vec3> corners(count);
+            for (auto &p: corners) {
+                get(p.x);
+                get(p.y);
+                get(p.z);
+            }
+            if (!in || count < 3) break;
+
+            auto mat = static_cast<nrcc::Materials>(material);
+            if (count == 3) faces.push_back({corners[0], corners[1], corners[2], mat});
+            else faces.push_back({polygons.emplace_back(std::move(corners)), mat});
+        }
+        if (faces.size() != n) std::cerr << "Error: Tile " << tile << " of " << directory << " is damaged\n";
+
+        return Mesh{faces};
+    }
+
+    static uint64_t footprint(const Mesh &mesh) {
+        uint64_t bytes = sizeof(Mesh) + mesh.top.nodes.size() * sizeof(typename Tree::Node);
+        for (const auto &group: mesh.groups) {
+            bytes += group.faces.capacity() * sizeof(Face);
+            bytes += group.tree.nodes.capacity() * sizeof(typename Tree::Node);
+            bytes += group.tree.indices.capacity() * sizeof(uint64_t);
+            bytes += group.polygons.capacity() * sizeof(std::vector<Vec3>);
+            for (const auto &polygon: group.polygons) bytes += polygon.capacity() * sizeof(Vec3);
+        }
+        return bytes;
+    }
+};
+
+#endif //NARCCISSUS_TILE_HPP
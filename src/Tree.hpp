@@ -0,0 +1,169 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Bounding volume hierarchy over axis aligned boxes. The tree only knows boxes and the indices of whatever they bound,
+// so the same structure indexes faces, edges or whole groups of faces. Nodes are stored flat: a branch points at its
+// two consecutive children, a leaf at a run of "indices".
+//
+// Trees over moving primitives can be refit in place: the hierarchy is kept and only the boxes are recomputed, which
+// is linear in the node count. Quality degrades if primitives travel far from where they were built, so callers may
+// still rebuild every so often.
+//
+// Traversal takes a visitor called as visit(index, limit) for every primitive whose box the ray enters before limit.
+// The visitor may shrink limit to prune farther nodes (closest hit) and returns true to stop the traversal (any hit).
+
+#ifndef NARCCISSUS_TREE_HPP
+#define NARCCISSUS_TREE_HPP
+
+#include <vector>
+#include <algorithm>
+#include "Vec3.hpp"
+#include "Util.hpp"
+
+template<typename type>
+class Tree {
+    using Vec3 = Vec3<type>;
+    using Box = std::array<Vec3, 2>;
+
+public:
+    struct Node {
+        Box box;
+        uint64_t first;
+        uint64_t count;
+    };
+
+    // VARIABLES
+    std::vector<Node> nodes;
+    std::vector<uint64_t> indices;
+
+    uint64_t leaf_size = 4;
+
+    // METHODS
+    void build(const std::vector<Box> &boxes) {
+        nodes.clear();
+        indices.resize(boxes.size());
+        for (uint64_t i = 0; i < boxes.size(); i++) indices[i] = i;
+
+        if (boxes.empty()) return;
+
+        nodes.reserve(2 * boxes.size() / leaf_size + 1);
+        nodes.push_back({{}, 0, boxes.size()});
+        split(0, boxes);
+    }
+
+    // Recomputes every node box from the current primitive boxes while keeping the topology. Children are always
+    // stored after their parent, so one backwards sweep sees both children before the branch that holds them.
+    void refit(const std::vector<Box> &boxes) {
+        for (uint64_t n = nodes.size(); n-- > 0;) {
+            Node &node = nodes[n];
+            if (node.count > 0) {
+                node.box = boxes[indices[node.first]];
+                for (uint64_t i = node.first + 1; i < node.first + node.count; i++) {
+                    node.box = merge(node.box, boxes[indices[i]]);
+                }
+            }
+            else node.box = merge(nodes[node.first].box, nodes[node.first + 1].box);
+        }
+    }
+
+    bool empty() const {
+        return nodes.empty();
+    }
+
+    template<typename F>
+    void traverse(const Vec3 &origin, const Vec3 &direct, type limit, F &&visit) const {
+        if (nodes.empty()) return;
+
+        Vec3 inverse = {1 / direct.x, 1 / direct.y, 1 / direct.z};
+
+        uint64_t stack[64];
+        uint64_t depth = 0;
+        stack[depth++] = 0;
+
+        while (depth > 0) {
+            const Node &node = nodes[stack[--depth]];
+
+            // Misses enter at infinity, so they are pruned even before any limit is set.
+            if (entry(node.box, origin, inverse) >= limit) continue;
+
+            if (node.count > 0) {
+                for (uint64_t i = node.first; i < node.first + node.count; i++) {
+                    if (visit(indices[i], limit)) return;
+                }
+            }
+            else {
+                type near = entry(nodes[node.first].box, origin, inverse);
+                type far = entry(nodes[node.first + 1].box, origin, inverse);
+
+                if (near <= far) {
+                    stack[depth++] = node.first + 1;
+                    stack[depth++] = node.first;
+                }
+                else {
+                    stack[depth++] = node.first;
+                    stack[depth++] = node.first + 1;
+                }
+            }
+        }
+    }
+
+    // Distance at which a ray enters a box, or infinity if it misses.
+    static type entry(const Box &box, const Vec3 &origin, const Vec3 &inverse) {
+        type t_min = 0;
+        type t_max = nrcc::infinity;
+        for (int a = 0; a < 3; a++) {
+            type t0 = (box[0].v[a] - origin.v[a]) * inverse.v[a];
+            type t1 = (box[1].v[a] - origin.v[a]) * inverse.v[a];
+            if (t0 > t1) std::swap(t0, t1);
+            t_min = t0 > t_min ? t0 : t_min;
+            t_max = t1 < t_max ? t1 : t_max;
+        }
+        return t_min <= t_max ? t_min : nrcc::infinity;
+    }
+
+    static Box merge(const Box &a, const Box &b) {
+        return {Vec3{std::min(a[0].x, b[0].x), std::min(a[0].y, b[0].y), std::min(a[0].z, b[0].z)},
+                Vec3{std::max(a[1].x, b[1].x), std::max(a[1].y, b[1].y), std::max(a[1].z, b[1].z)}};
+    }
+
+private:
+    // Median split along the longest axis of the centroids. Depth stays logarithmic, which the fixed traversal
+    // stack relies on.
+    void split(const uint64_t &n, const std::vector<Box> &boxes) {
+        uint64_t first = nodes[n].first;
+        uint64_t count = nodes[n].count;
+
+        Box box = boxes[indices[first]];
+        Box centroids = {center(box), center(box)};
+        for (uint64_t i = first; i < first + count; i++) {
+            box = merge(box, boxes[indices[i]]);
+            centroids = merge(centroids, {center(boxes[indices[i]]), center(boxes[indices[i]])});
+        }
+        nodes[n].box = box;
+
+        if (count <= leaf_size) return;
+
+        Vec3 extent = centroids[1] - centroids[0];
+        int axis = (extent.x > extent.y && extent.x > extent.z) ? 0 : (extent.y > extent.z) ? 1 : 2;
+
+        uint64_t half = count / 2;
+        std::nth_element(indices.begin() + first, indices.begin() + first + half, indices.begin() + first + count,
+                         [&](const uint64_t &i, const uint64_t &j) {
+                             return center(boxes[i]).v[axis] < center(boxes[j]).v[axis];
+                         });
+
+        uint64_t child = nodes.size();
+        nodes.push_back({{}, first, half});
+        nodes.push_back({{}, first + half, count - half});
+        nodes[n].first = child;
+        nodes[n].count = 0;
+
+        split(child, boxes);
+        split(child + 1, boxes);
+    }
+
+    static Vec3 center(const Box &box) {
+        return (box[0] + box[1]) * 0.5;
+    }
+};
+
+#endif //NARCCISSUS_TREE_HPP
@@ -43,6 +43,26 @@ namespace nrcc {
                                              {1, 0}};
     }
 
+    // Compile time configuration of the policy trace in Nrcc: the number of bounces, which interactions spawn waves,
+    // whether EM is evaluated as each wave is created rather than on first use, and whether receivers are tested
+    // during the trace or every wave is collected instead. Collected waves outlive their parents, so collecting is
+    // meant to be paired with eager EM.
+    template<uint8_t max_depth = 2, bool reflect = true, bool refract = true, bool eager_em = false,
+            bool test_receivers = true>
+    struct Policy {
+        static constexpr uint8_t depth = max_depth;
+        static constexpr bool reflection = reflect;
+        static constexpr bool refraction = refract;
+        static constexpr bool eager = eager_em;
+        static constexpr bool receive = test_receivers;
+    };
+
+    using Specular = Policy<2, true, false>;
+
+    using SingleBounce = Policy<1, true, false>;
+
+    using Collect = Policy<2, true, true, true, false>;
+
     enum Interactions {
         emission,
         reflection,
@@ -88,8 +108,22 @@ namespace nrcc {
             {nrcc::Materials::swamp,    {0.1500,  1.3000}},
     };
 
+    // https://www.itu.int/dms_pubrec/itu-r/rec/p/R-REC-P.2040-1-201507-S!!PDF-E.pdf
     template<typename type>
-    std::vector<Vec3<type>> icosphere(int subdivs) {
+    std::complex<type> refractiveIndex(const Materials &material, const type &frequency) {
+        type n = permittivity[material][0] * std::pow(frequency, permittivity[material][1]);
+
+        type c = conductivity[material][0] * std::pow(frequency, conductivity[material][1]);
+
+        type k = 17.98 * c / frequency;
+
+        return {n, k};
+    }
+
+    // Also returns the triangles of the last subdivision, as indices into the vertices, for launching ray tubes.
+    // Vertices are not shared between subdivided faces, so the list holds repeats.
+    template<typename type>
+    std::vector<Vec3<type>> icosphere(int subdivs, std::vector<std::array<uint64_t, 3>> &triangles) {
         const type X = 0.525731112119133606;
         const type Z = 0.850650808352039932;
 
@@ -155,9 +189,83 @@ namespace nrcc {
             faces = fs;
             vertices = vs;
         }
+
+        triangles.clear();
+        for (const auto &face: faces) {
+            triangles.push_back({static_cast<uint64_t>(face.x), static_cast<uint64_t>(face.y),
+                                 static_cast<uint64_t>(face.z)});
+        }
         return vertices;
     }
 
+    template<typename type>
+    std::vector<Vec3<type>> icosphere(int subdivs) {
+        std::vector<std::array<uint64_t, 3>> triangles;
+        return icosphere<type>(subdivs, triangles);
+    }
+
+    // The samplers below return exactly "count" unit directions of equal solid angle, unlike the 10 * 4^n + 2 of
+    // icosphere. Each maps points of the unit square to the sphere by area, with z = 1 - 2u and azimuth 2 pi v.
+    template<typename type>
+    Vec3<type> sphere(const type &u, const type &v) {
+        return {std::asin(1 - 2 * u), 2 * pi * v};
+    }
+
+    // Golden angle spiral. Deterministic, and the most even of the three for a given count.
+    template<typename type>
+    std::vector<Vec3<type>> fibonacci(const uint64_t &count) {
+        const type golden = (std::sqrt(type(5)) - 1) / 2;
+
+        std::vector<Vec3<type>> directions;
+        directions.reserve(count);
+        for (uint64_t i = 0; i < count; i++) {
+            type v = i * golden;
+            directions.push_back(sphere<type>((i + 0.5) / count, v - std::floor(v)));
+        }
+        return directions;
+    }
+
+    // One jittered point per cell of an equal area grid. Rows hold whole numbers of cells and are as tall as their
+    // share of the count, so every cell covers exactly 4 pi / count.
+    template<typename type>
+    std::vector<Vec3<type>> stratified(const uint64_t &count, Rand &generator) {
+        uint64_t rows = std::max<uint64_t>(1, std::sqrt(type(count) / 2));
+
+        std::vector<Vec3<type>> directions;
+        directions.reserve(count);
+        for (uint64_t r = 0; r < rows; r++) {
+            uint64_t first = count * r / rows;
+            uint64_t cells = count * (r + 1) / rows - first;
+            for (uint64_t c = 0; c < cells; c++) {
+                type u = (first + cells * generator.uniform()) / count;
+                type v = (c + generator.uniform()) / cells;
+                directions.push_back(sphere<type>(u, v));
+            }
+        }
+        return directions;
+    }
+
+    // First two dimensions of the Sobol sequence, starting "skip" points in so consecutive runs can be chained.
+    template<typename type>
+    std::vector<Vec3<type>> sobol(const uint64_t &count, const uint64_t &skip = 0) {
+        std::vector<Vec3<type>> directions;
+        directions.reserve(count);
+        for (uint64_t i = skip; i < skip + count; i++) {
+            uint32_t a = 0;
+            uint32_t b = 0;
+            uint32_t d = 1u << 31;
+            for (uint64_t k = i, bit = 0; k > 0 && bit < 32; k >>= 1, bit++) {
+                if (k & 1) {
+                    a ^= 1u << (31 - bit);
+                    b ^= d;
+                }
+                d ^= d >> 1;
+            }
+            directions.push_back(sphere<type>(a * 0x1.0p-32, b * 0x1.0p-32));
+        }
+        return directions;
+    }
+
     template<typename T>
     T intersectionDistance(const Vec3<T> &origin, const Vec3<T> &direct, const Vec3<T> &center, const T &radius) {
         Vec3 length = origin - center;
@@ -188,6 +296,30 @@ namespace nrcc {
         }
     }
 
+    // UTD transition function F(x) = 2j sqrt(x) exp(jx) int_sqrt(x)^inf exp(-j t^2) dt. The tail integral is taken as
+    // the full integral minus its power series for small x, and the asymptotic expansion is used for large x.
+    template<typename T>
+    std::complex<T> transition(const T &x) {
+        using cmpx = std::complex<T>;
+
+        if (x > 16) {
+            return cmpx(1 - 3 / (4 * x * x) + 75 / (16 * x * x * x * x), 1 / (2 * x) - 15 / (8 * x * x * x));
+        }
+
+        T u = std::sqrt(x);
+
+        cmpx term = u;
+        cmpx series = u;
+        for (int n = 1; n < 80 && std::abs(term) > 1e-17 * std::abs(series); n++) {
+            term *= cmpx(0, -1) * x / T(n);
+            series += term / T(2 * n + 1);
+        }
+
+        cmpx tail = std::sqrt(pi) / 2 * std::exp(cmpx(0, -pi / 4)) - series;
+
+        return cmpx(0, 2) * u * std::exp(cmpx(0, x)) * tail;
+    }
+
 }
 
 #endif //NARCCISSUS_UTIL_HPP
\ No newline at end of file
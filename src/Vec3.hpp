@@ -8,6 +8,7 @@
 #include <chrono>
 #include <complex>
 #include <iostream>
+#include "Rand.hpp"
 
 template<typename type>
 struct Vec3 {
@@ -72,7 +73,7 @@ struct Vec3 {
     // CONSTRUCTORS
     Vec3() : v{-7, -7, -7} {}
 
-    Vec3(const Vec3 &v) : v{v.x, v.y, v.z} {}
+    Vec3(const Vec3 &v) = default;
 
     Vec3(const type &x, const type &y, const type &z) : v{x, y, z} {}
 
@@ -156,15 +157,9 @@ Vec3<T> shift(const Vec3<T> &v, const Vec3<U> &w) {
 
 // OTHER
 template<typename T>
-Vec3<T> randomVector() {
-    unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-
-    std::default_random_engine generator(seed);
-
-    std::uniform_real_distribution<T> distribution(0.0, 1.0);
-
-    T u = distribution(generator);
-    T v = distribution(generator);
+Vec3<T> randomVector(Rand &generator) {
+    T u = generator.uniform();
+    T v = generator.uniform();
 
     T EL = std::acos(1 - 2 * u) - (std::numbers::pi_v<T> / 2);
     T AZ = 2 * std::numbers::pi_v<T> * v;
@@ -172,6 +167,11 @@ Vec3<T> randomVector() {
     return {EL, AZ};
 }
 
+template<typename T>
+Vec3<T> randomVector() {
+    return randomVector<T>(Rand::local());
+}
+
 // OSTREAM OVERLOAD
 template<typename T>
 std::ostream &operator<<(std::ostream &os, const Vec3<T> &v) {
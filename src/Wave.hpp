@@ -13,6 +13,8 @@
 #define NARCCISSUS_WAVE_HPP
 
 #include "Face.hpp"
+#include "Edge.hpp"
+#include "Fres.hpp"
 #include <iterator>
 
 template<typename type>
@@ -21,6 +23,8 @@ class Wave {
     using VecC = Vec3<cmpx>;
     using Vec3 = Vec3<type>;
     using Face = Face<type>;
+    using Edge = Edge<type>;
+    using Fres = Fres<type>;
 
 public:
     // VARIABLES
@@ -36,9 +40,10 @@ public:
 
     struct {
         Wave *wave;
-        Face *face;
+        const Face *face;
         type distance;
         nrcc::Interactions interaction;
+        Edge *edge;
     } genesis;
 
 public:
@@ -115,6 +120,44 @@ public:
         return cross(electricField(r), direct); // Inaccurate used for visualization
     }
 
+    // BATCHED FIELD METHODS
+    // Samples the fields at count evenly spaced distances start + i * step into the contiguous buffer e_fields and,
+    // if given, m_fields. Since only phase is length dependent, each sample is the previous one rotated by the constant
+    // phasor exp(j k step). The phasor is re-anchored with an exact exp every "anchoring" samples so that rounding
+    // error stays bounded regardless of count. Either buffer may be null.
+    static constexpr uint64_t anchoring = 64;
+
+    void fields(const type &start, const type &step, const uint64_t &count, VecC *e_fields, VecC *m_fields = nullptr) {
+        if (initial.amplitude == -7.0) initializeEm();
+
+        VecC p = polar(start) * cmpx(amplitude(start));
+        cmpx rotor = std::exp(nrcc::j * wavenumber(start) * step);
+
+        for (uint64_t i = 0; i < count; i += anchoring) {
+            cmpx phasor = std::exp(phase(start + step * i) * nrcc::j);
+
+            uint64_t n = std::min(count, i + anchoring);
+            for (uint64_t m = i; m < n; m++) {
+                VecC e = p * phasor;
+                if (e_fields != nullptr) e_fields[m] = e;
+                if (m_fields != nullptr) m_fields[m] = cross(e, direct);
+                phasor *= rotor;
+            }
+        }
+    }
+
+    std::vector<VecC> electricFields(const type &start, const type &step, const uint64_t &count) {
+        std::vector<VecC> e_fields(count);
+        fields(start, step, count, e_fields.data());
+        return e_fields;
+    }
+
+    std::vector<VecC> magneticFields(const type &start, const type &step, const uint64_t &count) {
+        std::vector<VecC> m_fields(count);
+        fields(start, step, count, nullptr, m_fields.data());
+        return m_fields;
+    }
+
     // EM PROPERTY INITIALIZER
     void initializeFreq() {
         initial.frequency = genesis.wave->frequency(genesis.distance);
@@ -124,44 +167,65 @@ public:
     void initializeEm() {
         if (initial.frequency == -7) initializeFreq();
 
+        if (genesis.interaction == nrcc::diffraction) return initializeDiffraction();
+
         Vec3 n = genesis.face->normal();
-        Vec3 t = genesis.face->bounds[0].unit();
+        Vec3 ki = genesis.wave->direct.unit();
 
         VecC Ei = genesis.wave->electricField(genesis.distance);
 
-        VecC Ep = n.cmpx() * dot(Ei, n) / pow(n.norm(), 2); // TODO: CHECK IF CONJUGATE NEEDED
-        VecC Es = Ei - Ep;
+        // The field splits into its components along s, perpendicular to the plane of incidence, and along s x k of the
+        // incident ray. They leave along s and s x k of this wave. Any s serves at normal incidence.
+        Vec3 s = cross(ki, n);
+        s = s.norm() > nrcc::epsilon ? s.unit() : genesis.face->bounds[0].unit();
+        cmpx Es = dot(Ei, s);
+        cmpx Ep = dot(Ei, cross(s, ki));
+        Vec3 p = cross(s, direct.unit());
+
+        // Angle of incidence from the geometry, not the field. Coefficients come from the table of the material pair,
+        // see Fres.hpp.
+        const Face *parent = genesis.wave->genesis.face;
+        nrcc::Materials from = parent == nullptr ? nrcc::vacuum : parent->material;
+        const Fres &fresnel = Fres::table(from, genesis.face->material, initial.frequency);
+        typename Fres::Coefficients c = fresnel(std::abs(dot(ki, n)));
 
-        cmpx n1 = (genesis.wave->genesis.face == nullptr) ? cmpx(1) :
-                  genesis.wave->genesis.face->refractiveIndex(initial.frequency);
-        cmpx n2 = genesis.face->refractiveIndex(initial.frequency);
+        if (genesis.interaction == nrcc::reflection) {
+            initializeField(s.cmpx() * (Es * c[0]) + p.cmpx() * (Ep * c[1]));
+        }
+        else if (genesis.interaction == nrcc::refraction) {
+            initializeField(s.cmpx() * (Es * c[2]) + p.cmpx() * (Ep * c[3]));
+        }
+    }
 
-        cmpx cos_i = dot(Ei, n);
-        cmpx sin_i = std::sqrt(cmpx(1.0) - cos_i * cos_i);
+    // Diffracted fields are split along the edge fixed unit vectors beta and phi of the incident and diffracted rays,
+    // and scaled by the soft and hard UTD coefficients respectively. The incident ray runs from the parent's origin to
+    // the point of diffraction on the edge. Like the other interactions, no spreading loss is applied beyond the edge.
+    void initializeDiffraction() {
+        Vec3 si = (origin - genesis.wave->origin).unit();
+        Vec3 sd = direct.unit();
+        Vec3 e = genesis.edge->direct();
 
-        cmpx sin_t = n1 / n2 * sin_i;
-        cmpx cos_t = std::sqrt(cmpx(1.0) - sin_t * sin_t);
+        Vec3 phi_i = cross(e, si).unit() * -1;
+        Vec3 phi_d = cross(e, sd).unit();
+        Vec3 beta_i = cross(phi_i, si);
+        Vec3 beta_d = cross(phi_d, sd);
 
-        if (genesis.interaction == nrcc::reflection) {
-            cmpx rs = (n2 * cos_i - n1 * cos_t) / (n2 * cos_i + n1 * cos_t);
-            cmpx rp = (n1 * cos_i - n2 * cos_t) / (n1 * cos_i + n2 * cos_t);
+        VecC Ei = genesis.wave->electricField(genesis.distance);
 
-            VecC Er = Es * rs + Ep * rp;
+        std::array<cmpx, 2> d = genesis.edge->coefficients(si, sd, initial.frequency, genesis.distance);
 
-            initial.amplitude = Er.real().norm();
-            initial.phase = std::atan2(dot(Er.imag(), Er.real()), Er.real().norm());
-            initial.polar = shift(Er, direct).unit();
-        }
-        else if (genesis.interaction == nrcc::refraction) {
-            cmpx ts = (cmpx(2) * n1 * cos_i) / (n1 * cos_i = n2 * cos_t);
-            cmpx tp = (cmpx(2) * n1 * cos_i) / (n1 * cos_t = n2 * cos_i);
+        initializeField(beta_d.cmpx() * (dot(Ei, beta_i) * -d[0]) + phi_d.cmpx() * (dot(Ei, phi_i) * -d[1]));
+    }
 
-            VecC Et = Es * ts + Ep * tp;
+    // Takes the field leaving the origin, transverse part only. The complex polarization keeps its phase, and is scaled
+    // by its Hermitian norm: the bilinear norm() of a complex vector can vanish for elliptical fields.
+    void initializeField(const VecC &field) {
+        VecC transverse = shift(field, direct);
+        type magnitude = std::sqrt(std::norm(transverse.x) + std::norm(transverse.y) + std::norm(transverse.z));
 
-            initial.amplitude = Et.real().norm();
-            initial.phase = std::atan2(dot(Et.imag(), Et.real()), Et.real().norm());
-            initial.polar = shift(Et, direct).unit();
-        }
+        initial.amplitude = magnitude;
+        initial.phase = 0;
+        initial.polar = magnitude > 0 ? transverse / cmpx(magnitude) : VecC{0, 0, 0};
     }
 
     // PARENT WAVE CONSTRUCTOR
@@ -174,18 +238,28 @@ public:
             origin(origin),
             direct(direct),
             initial{frequency, amplitude, phase, shift(polar, direct)},
-            genesis{nullptr, nullptr, 0, nrcc::emission} {}
+            genesis{nullptr, nullptr, 0, nrcc::emission, nullptr} {}
 
     // CHILD WAVE CONSTRUCTOR
     Wave(const Vec3 &origin,
          const Vec3 &direct,
          Wave *parent_wave,
-         Face *parent_face,
+         const Face *parent_face,
          const nrcc::Interactions &interaction) :
             origin(origin),
             direct(direct),
-            genesis{parent_wave, parent_face, range(parent_wave->origin, origin), interaction},
-            initial{parent_wave->initial.frequency, -7.0, -7.0} {}
+            initial{parent_wave->initial.frequency, -7.0, -7.0, {}},
+            genesis{parent_wave, parent_face, range(parent_wave->origin, origin), interaction, nullptr} {}
+
+    // DIFFRACTED WAVE CONSTRUCTOR
+    Wave(const Vec3 &origin,
+         const Vec3 &direct,
+         Wave *parent_wave,
+         Edge *parent_edge) :
+            origin(origin),
+            direct(direct),
+            initial{parent_wave->initial.frequency, -7.0, -7.0, {}},
+            genesis{parent_wave, nullptr, range(parent_wave->origin, origin), nrcc::diffraction, parent_edge} {}
 };
 
 // OSTREAM
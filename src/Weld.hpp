@@ -0,0 +1,151 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Load time clean up of face sets, meant to run on the output of read():
+//
+//   std::vector<std::vector<Vec3<double>>> polygons;
+//   Mesh<double> mesh{merge(weld(read<double>(file)), polygons)};
+//
+// weld() snaps vertices that lie within tolerance of each other onto one position, then drops faces that became
+// degenerate (two corners welded together, or thinner than tolerance) and faces that repeat another's corners.
+//
+// merge() grows convex polygons out of adjacent faces that share a material and a plane. A face joins a polygon across
+// an edge they share in opposite directions, so only consistently wound neighbours merge, and only if the polygon stays
+// convex. Corners must match exactly, which weld() guarantees. Polygons are capped at "limit" corners to keep the
+// per-face intersection test short. The corners of the polygons are appended to "polygons", which the merged faces
+// refer to: keep it until the faces are added to a Mesh, which makes its own copy.
+
+#ifndef NARCCISSUS_WELD_HPP
+#define NARCCISSUS_WELD_HPP
+
+#include <set>
+#include "Face.hpp"
+
+template<typename type>
+std::vector<Face<type>> weld(const std::vector<Face<type>> &faces, const type &tolerance = 1e-6) {
+    using Vec3 = Vec3<type>;
+    using Key = std::array<int64_t, 3>;
+
+    auto quantize = [&](const Vec3 &p) {
+        return Key{std::llround(p.x / tolerance), std::llround(p.y / tolerance), std::llround(p.z / tolerance)};
+    };
+
+    // A welded vertex is found in the cell of the point or any of its neighbours.
+    std::vector<Vec3> vertices;
+    std::map<Key, uint64_t> cells;
+    auto vertex = [&](const Vec3 &p) {
+        Key k = quantize(p);
+        for (int64_t dx = -1; dx <= 1; dx++) {
+            for (int64_t dy = -1; dy <= 1; dy++) {
+                for (int64_t dz = -1; dz <= 1; dz++) {
+                    auto found = cells.find({k[0] + dx, k[1] + dy, k[2] + dz});
+                    if (found != cells.end() && range(vertices[found->second], p) <= tolerance) return found->second;
+                }
+            }
+        }
+        cells[k] = vertices.size();
+        vertices.push_back(p);
+        return cells[k];
+    };
+
+    std::vector<Face<type>> welded;
+    std::set<std::array<uint64_t, 3>> seen;
+    for (const auto &face: faces) {
+        std::array<uint64_t, 3> ids = {vertex(face.points[0]), vertex(face.points[1]), vertex(face.points[2])};
+        if (ids[0] == ids[1] || ids[1] == ids[2] || ids[2] == ids[0]) continue;
+
+        const Vec3 &p = vertices[ids[0]];
+        const Vec3 &q = vertices[ids[1]];
+        const Vec3 &r = vertices[ids[2]];
+        type longest = std::max({range(p, q), range(q, r), range(r, p)});
+        if (cross(q - p, r - p).norm() / longest < tolerance) continue;
+
+        std::array<uint64_t, 3> sorted = ids;
+        std::sort(sorted.begin(), sorted.end());
+        if (!seen.insert(sorted).second) continue;
+
+        welded.push_back({p, q, r, face.material});
+    }
+    return welded;
+}
+
+template<typename type>
+std::vector<Face<type>> merge(const std::vector<Face<type>> &faces, std::vector<std::vector<Vec3<type>>> &polygons,
+                              const type &flatness = 1e-4, const type &tolerance = 1e-6, const uint64_t &limit = 16) {
+    using Vec3 = Vec3<type>;
+
+    std::vector<Vec3> vertices;
+    std::map<std::array<type, 3>, uint64_t> index;
+    auto vertex = [&](const Vec3 &p) {
+        auto [found, added] = index.insert({{p.x, p.y, p.z}, vertices.size()});
+        if (added) vertices.push_back(p);
+        return found->second;
+    };
+
+    // Faces by each directed edge they walk.
+    std::vector<std::array<uint64_t, 3>> triangles;
+    std::map<std::array<uint64_t, 2>, std::vector<uint64_t>> walks;
+    for (uint64_t f = 0; f < faces.size(); f++) {
+        triangles.push_back({vertex(faces[f].points[0]), vertex(faces[f].points[1]), vertex(faces[f].points[2])});
+        for (uint64_t i = 0; i < 3; i++) walks[{triangles[f][i], triangles[f][(i + 1) % 3]}].push_back(f);
+    }
+
+    // Left turn at corner b of a, b, c, allowing c to sit up to tolerance to the right of the line through a and b.
+    auto convex = [&](const uint64_t &a, const uint64_t &b, const uint64_t &c, const Vec3 &n) {
+        Vec3 u = vertices[b] - vertices[a];
+        return dot(cross(u, vertices[c] - vertices[b]), n) >= -tolerance * u.norm();
+    };
+
+    std::vector<uint8_t> used(faces.size(), 0);
+    std::vector<Face<type>> merged;
+    for (uint64_t seed = 0; seed < faces.size(); seed++) {
+        if (used[seed]) continue;
+        used[seed] = 1;
+
+        const Face<type> &base = faces[seed];
+        Vec3 n = base.normal();
+        type offset = dot(n, base.points[0]);
+        std::vector<uint64_t> loop = {triangles[seed].begin(), triangles[seed].end()};
+
+        bool grown = true;
+        while (grown && loop.size() < limit) {
+            grown = false;
+            for (uint64_t i = 0; i < loop.size() && !grown; i++) {
+                uint64_t a = loop[i];
+                uint64_t b = loop[(i + 1) % loop.size()];
+
+                auto found = walks.find({b, a});
+                if (found == walks.end()) continue;
+
+                for (const auto &f: found->second) {
+                    if (used[f] || faces[f].material != base.material) continue;
+                    if (dot(faces[f].normal(), n) < std::cos(flatness)) continue;
+
+                    uint64_t c = triangles[f][0] + triangles[f][1] + triangles[f][2] - a - b;
+                    if (std::fabs(dot(n, vertices[c]) - offset) > tolerance) continue;
+                    if (std::find(loop.begin(), loop.end(), c) != loop.end()) continue;
+
+                    uint64_t before = loop[(i + loop.size() - 1) % loop.size()];
+                    uint64_t after = loop[(i + 2) % loop.size()];
+                    if (!convex(before, a, c, n) || !convex(a, c, b, n) || !convex(c, b, after, n)) continue;
+
+                    loop.insert(loop.begin() + i + 1, c);
+                    used[f] = 1;
+                    grown = true;
+                    break;
+                }
+            }
+        }
+
+        if (loop.size() == 3) {
+            merged.push_back(base);
+            continue;
+        }
+
+        std::vector<Vec3> &outline = polygons.emplace_back();
+        for (const auto &v: loop) outline.push_back(vertices[v]);
+        merged.push_back({outline, base.material});
+    }
+    return merged;
+}
+
+#endif //NARCCISSUS_WELD_HPP
@@ -0,0 +1,190 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Implementation of the C interface in narccissus.h. Handles wrap the C++ objects directly, and buffers are strided
+// views into them, so nothing is copied on the way out. Exceptions never cross the interface.
+
+#include <fstream>
+#include <memory>
+#include "narccissus.h"
+#include "Mesh.hpp"
+#include "Nrcc.hpp"
+#include "Pole.hpp"
+#include "Taps.hpp"
+
+struct nrcc_scene {
+    Mesh<double> mesh;
+};
+
+struct nrcc_waves {
+    std::vector<Wave<double>> waves;
+};
+
+struct nrcc_result {
+    std::vector<Taps<double>> receivers;
+    std::vector<Vec3<std::complex<double>>> fields;
+    std::vector<double> powers;
+};
+
+namespace {
+    thread_local std::string error;
+
+    template<typename F>
+    auto guard(F &&f) -> decltype(f()) {
+        error.clear();
+        try {
+            return f();
+        }
+        catch (const std::exception &e) {
+            error = e.what();
+        }
+        catch (...) {
+            error = "unknown error";
+        }
+        return {};
+    }
+
+    Vec3<double> vec(const double *v) {
+        return {v[0], v[1], v[2]};
+    }
+
+    Pole<double> pole(const nrcc_pole &p) {
+        return {vec(p.coordinates), vec(p.orientation), p.frequency, p.length};
+    }
+}
+
+extern "C" {
+
+const char *nrcc_last_error(void) {
+    return error.c_str();
+}
+
+nrcc_scene *nrcc_scene_load(const char *obj_path) {
+    return guard([&]() -> nrcc_scene * {
+        std::ifstream obj(obj_path);
+        if (!obj) {
+            error = std::string("could not open ") + obj_path;
+            return nullptr;
+        }
+        return new nrcc_scene{Mesh<double>{read<double>(std::move(obj))}};
+    });
+}
+
+nrcc_scene *nrcc_scene_create(const double *vertices, size_t vertex_count, const uint64_t *triangles,
+                              size_t triangle_count, const int *materials) {
+    return guard([&]() -> nrcc_scene * {
+        std::vector<Face<double>> faces;
+        for (size_t i = 0; i < triangle_count; i++) {
+            const uint64_t *t = triangles + 3 * i;
+            if (t[0] >= vertex_count || t[1] >= vertex_count || t[2] >= vertex_count) {
+                error = "triangle " + std::to_string(i) + " indexes past the vertices";
+                return nullptr;
+            }
+            if (materials && (materials[i] < NRCC_VACUUM || materials[i] > NRCC_SWAMP)) {
+                error = "triangle " + std::to_string(i) + " has unknown material " + std::to_string(materials[i]);
+                return nullptr;
+            }
+            auto material = materials ? static_cast<nrcc::Materials>(materials[i]) : nrcc::concrete;
+            faces.push_back({vec(vertices + 3 * t[0]), vec(vertices + 3 * t[1]), vec(vertices + 3 * t[2]), material});
+        }
+        return new nrcc_scene{Mesh<double>{faces}};
+    });
+}
+
+size_t nrcc_scene_faces(const nrcc_scene *scene) {
+    return scene ? scene->mesh.size() : 0;
+}
+
+void nrcc_scene_free(nrcc_scene *scene) {
+    delete scene;
+}
+
+nrcc_waves *nrcc_transmit(const nrcc_pole *transmitter, double power, unsigned accuracy) {
+    return guard([&]() -> nrcc_waves * {
+        if (!transmitter) {
+            error = "no transmitter";
+            return nullptr;
+        }
+        Pole<double> tx = pole(*transmitter);
+        return new nrcc_waves{tx.transmit(power, 0, 2, accuracy)};
+    });
+}
+
+size_t nrcc_waves_count(const nrcc_waves *waves) {
+    return waves ? waves->waves.size() : 0;
+}
+
+nrcc_buffer nrcc_waves_directions(const nrcc_waves *waves) {
+    if (!waves || waves->waves.empty()) return {nullptr, 0, sizeof(Wave<double>), 3};
+    return {waves->waves[0].direct.v, waves->waves.size(), sizeof(Wave<double>), 3};
+}
+
+nrcc_buffer nrcc_waves_amplitudes(const nrcc_waves *waves) {
+    if (!waves || waves->waves.empty()) return {nullptr, 0, sizeof(Wave<double>), 1};
+    return {&waves->waves[0].initial.amplitude, waves->waves.size(), sizeof(Wave<double>), 1};
+}
+
+void nrcc_waves_free(nrcc_waves *waves) {
+    delete waves;
+}
+
+nrcc_result *nrcc_trace(const nrcc_scene *scene, const nrcc_waves *waves, uint8_t depth, const nrcc_pole *receivers,
+                        size_t receiver_count, double resolution, size_t bins) {
+    return guard([&]() -> nrcc_result * {
+        if (!scene || !waves) {
+            error = !scene ? "no scene" : "no waves";
+            return nullptr;
+        }
+        if (!receivers && receiver_count > 0) {
+            error = "no receivers";
+            return nullptr;
+        }
+        auto result = std::make_unique<nrcc_result>();
+        for (size_t i = 0; i < receiver_count; i++) result->receivers.push_back({pole(receivers[i]), resolution, bins});
+
+        Nrcc<double> tracer;
+        for (Wave<double> wave: waves->waves) tracer.trace(wave, scene->mesh, result->receivers, depth);
+
+        for (const auto &receiver: result->receivers) {
+            result->fields.push_back(receiver.field());
+            double p = 0;
+            for (const auto &bin: receiver.powers) p += bin;
+            result->powers.push_back(p);
+        }
+        return result.release();
+    });
+}
+
+size_t nrcc_result_count(const nrcc_result *result) {
+    return result ? result->receivers.size() : 0;
+}
+
+nrcc_buffer nrcc_result_positions(const nrcc_result *result) {
+    if (!result || result->receivers.empty()) return {nullptr, 0, sizeof(Taps<double>), 3};
+    return {result->receivers[0].pole.coordinates.v, result->receivers.size(), sizeof(Taps<double>), 3};
+}
+
+nrcc_buffer nrcc_result_fields(const nrcc_result *result) {
+    if (!result) return {nullptr, 0, sizeof(Vec3<std::complex<double>>), 6};
+    return {reinterpret_cast<const double *>(result->fields.data()), result->fields.size(),
+            sizeof(Vec3<std::complex<double>>), 6};
+}
+
+nrcc_buffer nrcc_result_powers(const nrcc_result *result) {
+    if (!result) return {nullptr, 0, sizeof(double), 1};
+    return {result->powers.data(), result->powers.size(), sizeof(double), 1};
+}
+
+nrcc_buffer nrcc_result_pdp(const nrcc_result *result, size_t receiver) {
+    if (!result || receiver >= result->receivers.size()) {
+        error = "no such receiver";
+        return {nullptr, 0, sizeof(double), 1};
+    }
+    const std::vector<double> &powers = result->receivers[receiver].powers;
+    return {powers.data(), powers.size(), sizeof(double), 1};
+}
+
+void nrcc_result_free(nrcc_result *result) {
+    delete result;
+}
+
+}
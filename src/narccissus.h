@@ -0,0 +1,113 @@
+/* Copyright(c) 2023, Matthew Petrin, All rights reserved. */
+
+/* C interface to the tracer, in double precision, for embedding in pipelines that are not C++.
+ *
+ * OWNERSHIP
+ * Every handle returned by a function of this interface belongs to the caller and must be released exactly once with
+ * the matching nrcc_*_free function. Freeing NULL does nothing. Functions never take ownership of their arguments:
+ * input arrays are copied before they return.
+ *
+ * BUFFERS
+ * Results are exposed as nrcc_buffer views into memory owned by the handle they came from, not copies. An element i
+ * starts at (const char *) data + i * stride and is made of "width" consecutive doubles. A view stays valid, and its
+ * contents unchanged, until its handle is freed. Views are read only.
+ *
+ * THREADS
+ * A scene may be traced from several threads at once. Other handles must not be used from two threads at the same
+ * time. Errors are reported per thread: a function that fails returns NULL (or zero) and nrcc_last_error() then
+ * describes the failure until the next call from that thread.
+ */
+
+#ifndef NARCCISSUS_H
+#define NARCCISSUS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct nrcc_scene nrcc_scene;
+typedef struct nrcc_waves nrcc_waves;
+typedef struct nrcc_result nrcc_result;
+
+typedef struct {
+    const double *data;
+    size_t length;
+    size_t stride;
+    size_t width;
+} nrcc_buffer;
+
+typedef struct {
+    double coordinates[3];
+    double orientation[3];
+    double frequency;
+    double length;
+} nrcc_pole;
+
+/* Material codes, in the order of nrcc::Materials. */
+enum {
+    NRCC_VACUUM,
+    NRCC_CONCRETE,
+    NRCC_BRICK,
+    NRCC_WOOD,
+    NRCC_GLASS,
+    NRCC_METAL,
+    NRCC_DESERT,
+    NRCC_GROUND,
+    NRCC_SWAMP
+};
+
+const char *nrcc_last_error(void);
+
+/* SCENES */
+nrcc_scene *nrcc_scene_load(const char *obj_path);
+
+/* Triangles index into vertices (three doubles each). Materials holds one code per triangle, or NULL for concrete.
+ * A triangle with a code outside NRCC_VACUUM to NRCC_SWAMP fails the call. */
+nrcc_scene *nrcc_scene_create(const double *vertices, size_t vertex_count, const uint64_t *triangles,
+                              size_t triangle_count, const int *materials);
+
+size_t nrcc_scene_faces(const nrcc_scene *scene);
+
+void nrcc_scene_free(nrcc_scene *scene);
+
+/* TRANSMISSION
+ * Waves launched from a pole over the icosphere of the given accuracy, as Pole::transmit with a dipole exponent of 2.
+ */
+nrcc_waves *nrcc_transmit(const nrcc_pole *transmitter, double power, unsigned accuracy);
+
+size_t nrcc_waves_count(const nrcc_waves *waves);
+
+nrcc_buffer nrcc_waves_directions(const nrcc_waves *waves); /* width 3 */
+
+nrcc_buffer nrcc_waves_amplitudes(const nrcc_waves *waves); /* width 1 */
+
+void nrcc_waves_free(nrcc_waves *waves);
+
+/* TRACING
+ * Traces every wave through the scene to the given depth, accumulating at each receiver in delay bins of width
+ * resolution seconds. Scene and waves are not modified and may be freed afterwards. Receivers may be NULL only when
+ * receiver_count is zero.
+ */
+nrcc_result *nrcc_trace(const nrcc_scene *scene, const nrcc_waves *waves, uint8_t depth, const nrcc_pole *receivers,
+                        size_t receiver_count, double resolution, size_t bins);
+
+size_t nrcc_result_count(const nrcc_result *result);
+
+nrcc_buffer nrcc_result_positions(const nrcc_result *result); /* width 3, receiver coordinates */
+
+nrcc_buffer nrcc_result_fields(const nrcc_result *result); /* width 6, re x, im x, re y, im y, re z, im z */
+
+nrcc_buffer nrcc_result_powers(const nrcc_result *result); /* width 1, total incoherent power */
+
+nrcc_buffer nrcc_result_pdp(const nrcc_result *result, size_t receiver); /* width 1, power per delay bin */
+
+void nrcc_result_free(nrcc_result *result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* NARCCISSUS_H */
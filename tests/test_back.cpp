@@ -0,0 +1,69 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to compare reverse tracing against forward tracing for site selection in magnolia. A grid of candidate
+// transmitters is traced forward one at a time into a single receiver, then found all at once by one reverse trace from
+// the receiver. Both are reported with their times, and per candidate the coherent power of each and their difference.
+// Differences should be within the ray noise of the two launches, at a fraction of the forward time.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Nrcc.hpp"
+#include "../src/Back.hpp"
+
+int main() {
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+    using VecC = Vec3<std::complex<double>>;
+
+    double frequency = 2.4e9;
+    int accuracy = 6;
+
+    Mesh<double> mesh{read<double>((std::ifstream) "../data/magnolia.obj")};
+    mesh.add({{{-200, -40, -200}, {200, -40, 200}, {200, -40, -200}, nrcc::ground},
+              {{-200, -40, -200}, {-200, -40, 200}, {200, -40, 200}, nrcc::ground}});
+
+    std::vector<Taps> rxs = {{{{150, 20, 0}, {0, 1, 0}, frequency, 4}, 1e-9, 2000}};
+
+    std::vector<Pole> candidates;
+    for (int i = 0; i < 4; i++) {
+        for (int k = 0; k < 4; k++) candidates.push_back({{-150.0 + i * 40, 30, -60.0 + k * 40}, {0, 1, 0}, frequency, 4});
+    }
+
+    auto power = [](const VecC &e) { return std::norm(e.x) + std::norm(e.y) + std::norm(e.z); };
+
+    Nrcc<double> rt;
+    std::vector<double> forward;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const Pole &tx: candidates) {
+        std::vector<Taps> received = rxs;
+        for (Wave &wave: Pole(tx).transmit(1, 0, 2, accuracy)) rt.trace(wave, mesh, received, 3);
+        forward.push_back(power(received[0].field()));
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "forward: " << candidates.size() << " traces, "
+              << duration_cast<std::chrono::microseconds>(stop - start).count() << " us\n";
+
+    Back<double> back{candidates};
+    start = std::chrono::high_resolution_clock::now();
+    back.trace(mesh, rxs, accuracy, 3);
+    stop = std::chrono::high_resolution_clock::now();
+    std::cout << "reverse: " << back.arrivals << " arrivals, "
+              << duration_cast<std::chrono::microseconds>(stop - start).count() << " us\n";
+
+    std::vector<double> errors;
+    for (uint64_t t = 0; t < candidates.size(); t++) {
+        double p = power(back.channels[t][0].field());
+        double error = std::abs(10 * std::log10(p / forward[t]));
+        errors.push_back(error);
+        std::cout << "candidate " << t << ": forward " << 10 * std::log10(forward[t]) << " dB, reverse "
+                  << 10 * std::log10(p) << " dB, difference " << error << " dB\n";
+    }
+    std::sort(errors.begin(), errors.end());
+    std::cout << "median difference " << errors[errors.size() / 2] << " dB, worst " << errors.back() << " dB\n";
+
+    return 0;
+}
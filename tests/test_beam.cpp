@@ -0,0 +1,150 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to compare beam tracing and ray tracing with reception spheres against the image method solution of
+// the street canyon of test_conv.cpp. The canyon is a ground plane between two metal walls, so every path of up to
+// three reflections is found in closed form by mirroring the transmitter and unfolding the images, and its field comes
+// from the same Wave chain and power density as a beam reception. Receivers float clear of the ground and the walls.
+// Rays are traced at increasing accuracy, beams at low accuracies, and each run reports its launches, time and worst
+// coherent power error against the image method. Beams should match it to rounding once no path slips between the
+// corner rays of a resolved tube, from 320 tubes here; at 20 and 80 tubes a few of the 120 paths are missed. Rays
+// should not be expected to match: a 2 m reception sphere spans some 30 wavelengths at 2.4 GHz, so the rays it catches
+// mix their phases, and near interference nulls the ray result is several dB off the point field.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Nrcc.hpp"
+#include "../src/Beam.hpp"
+
+int main() {
+    using VecC = Vec3<std::complex<double>>;
+    using Vec3 = Vec3<double>;
+    using Face = Face<double>;
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+
+    double frequency = 2.4e9;
+
+    Mesh<double> canyon;
+    canyon.add({{{-200, 0, -15}, {200, 0, 15}, {200, 0, -15}, nrcc::ground},
+                {{-200, 0, -15}, {-200, 0, 15}, {200, 0, 15}, nrcc::ground},
+                {{-200, 0, -15}, {200, 0, -15}, {200, 30, -15}, nrcc::metal},
+                {{-200, 0, -15}, {200, 30, -15}, {-200, 30, -15}, nrcc::metal},
+                {{-200, 0, 15}, {200, 30, 15}, {200, 0, 15}, nrcc::metal},
+                {{-200, 0, 15}, {-200, 30, 15}, {200, 30, 15}, nrcc::metal}});
+
+    Pole tx = {{-100, 10, 0}, {0, 1, 0}, frequency, 1};
+
+    std::vector<Taps> rxs;
+    for (int i = 0; i < 10; i++) rxs.push_back({{{-50.0 + i * 20, 5, 5}, {0, 1, 0}, frequency, 2}, 1e-9, 2000});
+
+    auto power = [](const VecC &e) { return std::norm(e.x) + std::norm(e.y) + std::norm(e.z); };
+
+    // IMAGE METHOD
+    // The ground, the wall at z = -15 and the wall at z = 15, each by its first face.
+    std::array<Face *, 3> planes = {&canyon.face(0), &canyon.face(2), &canyon.face(4)};
+    auto within = [](const uint64_t &plane, const Vec3 &p) {
+        return std::fabs(p.x) <= 200 && (plane == 0 ? std::fabs(p.z) <= 15 : p.y >= 0 && p.y <= 30);
+    };
+    auto mirror = [](const Vec3 &p, const Face &face) {
+        Vec3 n = face.normal();
+        return p - n * (dot(p - face.points[0], n) * 2);
+    };
+
+    // The dipole launch shares power over the integral of sin^2 over the sphere, 8 pi / 3.
+    double density = 1 / (8 * nrcc::pi / 3);
+
+    std::vector<std::vector<uint64_t>> sequences = {{}};
+    for (uint64_t s = 0; s < sequences.size(); s++) {
+        if (sequences[s].size() == 3) continue;
+        for (uint64_t plane = 0; plane < 3; plane++) {
+            if (!sequences[s].empty() && sequences[s].back() == plane) continue;
+            sequences.push_back(sequences[s]);
+            sequences.back().push_back(plane);
+        }
+    }
+
+    std::vector<double> reference;
+    for (const auto &rx: rxs) {
+        const Vec3 &target = rx.pole.coordinates;
+        VecC field = {0, 0, 0};
+        for (const auto &sequence: sequences) {
+            uint64_t k = sequence.size();
+            std::vector<Vec3> images = {tx.coordinates};
+            for (const auto &plane: sequence) images.push_back(mirror(images.back(), *planes[plane]));
+
+            // Reflection points, from the receiver back towards the transmitter.
+            std::vector<Vec3> points(k + 2);
+            points[k + 1] = target;
+            bool valid = true;
+            for (uint64_t i = k; i > 0 && valid; i--) {
+                const Face &face = *planes[sequence[i - 1]];
+                Vec3 n = face.normal();
+                Vec3 towards = points[i + 1] - images[i];
+                double t = dot(face.points[0] - images[i], n) / dot(towards, n);
+                points[i] = images[i] + towards * t;
+                valid = t > 0 && t < 1 && within(sequence[i - 1], points[i]);
+            }
+            if (!valid) continue;
+            points[0] = tx.coordinates;
+
+            double length = range(images.back(), target);
+            Vec3 departure = (points[1] - points[0]).unit();
+            double amplitude = density * std::pow(cross(departure, tx.orientation).norm(), 2) / (length * length) *
+                               nrcc::pi * rx.pole.length * rx.pole.length;
+
+            std::vector<Wave> path;
+            path.reserve(k + 1);
+            path.push_back({points[0], departure, frequency, amplitude, 0, tx.orientation.cmpx()});
+            for (uint64_t i = 1; i <= k; i++) {
+                path.push_back({points[i], (points[i + 1] - points[i]).unit(), &path.back(), planes[sequence[i - 1]],
+                                nrcc::reflection});
+            }
+            field = field + path.back().electricField(range(path.back().origin, target));
+        }
+        reference.push_back(power(field));
+    }
+
+    Nrcc<double> rt;
+    for (int accuracy = 8; accuracy >= 4; accuracy--) {
+        std::vector<Taps> received = rxs;
+        std::vector<Wave> waves = tx.transmit(1, 0, 2, accuracy);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (Wave &wave: waves) rt.trace(wave, canyon, received, 3);
+        auto stop = std::chrono::high_resolution_clock::now();
+
+        double error = 0;
+        for (uint64_t r = 0; r < rxs.size(); r++) {
+            double p = power(received[r].field());
+            error = std::max(error, p > 0 ? std::abs(10 * std::log10(p / reference[r])) : nrcc::infinity);
+        }
+        std::cout << "rays, accuracy " << accuracy << ": " << waves.size() << " rays, "
+                  << duration_cast<std::chrono::microseconds>(stop - start).count() << " us, power " << error
+                  << " dB\n";
+    }
+
+    Beam<double> beams;
+    for (int accuracy = 0; accuracy <= 3; accuracy++) {
+        std::vector<Taps> received = rxs;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        beams.trace(tx, 1, 0, 2, accuracy, canyon, received, 3);
+        auto stop = std::chrono::high_resolution_clock::now();
+
+        double error = 0;
+        for (uint64_t r = 0; r < rxs.size(); r++) {
+            double p = power(received[r].field());
+            error = std::max(error, p > 0 ? std::abs(10 * std::log10(p / reference[r])) : nrcc::infinity);
+        }
+        std::cout << "beams, accuracy " << accuracy << ": " << 20 * (1 << 2 * accuracy) << " tubes, "
+                  << beams.resolved << " resolved, " << beams.divided << " splits, " << beams.credited
+                  << " receptions, " << duration_cast<std::chrono::microseconds>(stop - start).count()
+                  << " us, power " << error << " dB\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+/* Copyright(c) 2023, Matthew Petrin, All rights reserved. */
+
+/* Test designed to drive the tracer through the C interface alone, compiled as C. A scene is loaded, waves transmitted
+ * and traced to a row of receivers, and the results read through the strided buffers without copying. NULL arguments
+ * and unknown material codes must fail with an error rather than crash. */
+
+#include <stdio.h>
+#include "../src/narccissus.h"
+
+static const double *element(nrcc_buffer buffer, size_t i) {
+    return (const double *) ((const char *) buffer.data + i * buffer.stride);
+}
+
+int main(void) {
+    nrcc_scene *missing = nrcc_scene_load("../data/missing.obj");
+    printf("missing scene: %p, error: %s\n", (void *) missing, nrcc_last_error());
+
+    double vertices[] = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+    uint64_t triangle[] = {0, 1, 2};
+    int bad_material[] = {NRCC_SWAMP + 1};
+    nrcc_scene *unknown = nrcc_scene_create(vertices, 3, triangle, 1, bad_material);
+    printf("unknown material: %p, error: %s\n", (void *) unknown, nrcc_last_error());
+
+    nrcc_scene *scene = nrcc_scene_load("../data/magnolia.obj");
+    printf("faces: %zu\n", nrcc_scene_faces(scene));
+
+    nrcc_pole tx = {{-150, 30, 120}, {0, 1, 0}, 2.4e9, 1};
+    nrcc_waves *waves = nrcc_transmit(&tx, 1, 5);
+
+    nrcc_buffer directions = nrcc_waves_directions(waves);
+    const double *first = element(directions, 0);
+    printf("waves: %zu, first direction: %g, %g, %g\n", directions.length, first[0], first[1], first[2]);
+
+    nrcc_pole rxs[10];
+    for (int i = 0; i < 10; i++) {
+        nrcc_pole rx = {{150, 20, -100.0 + i * 20}, {0, 1, 0}, 2.4e9, 4};
+        rxs[i] = rx;
+    }
+
+    nrcc_waves *no_waves = nrcc_transmit(NULL, 1, 5);
+    printf("no transmitter: %p, error: %s\n", (void *) no_waves, nrcc_last_error());
+    nrcc_result *no_result = nrcc_trace(NULL, waves, 2, rxs, 10, 1e-9, 2000);
+    printf("no scene: %p, error: %s\n", (void *) no_result, nrcc_last_error());
+    no_result = nrcc_trace(scene, NULL, 2, rxs, 10, 1e-9, 2000);
+    printf("no waves: %p, error: %s\n", (void *) no_result, nrcc_last_error());
+    no_result = nrcc_trace(scene, waves, 2, NULL, 10, 1e-9, 2000);
+    printf("no receivers: %p, error: %s\n", (void *) no_result, nrcc_last_error());
+
+    nrcc_result *result = nrcc_trace(scene, waves, 2, rxs, 10, 1e-9, 2000);
+
+    /* The scene and waves are no longer needed once traced. */
+    nrcc_waves_free(waves);
+    nrcc_scene_free(scene);
+
+    nrcc_buffer positions = nrcc_result_positions(result);
+    nrcc_buffer fields = nrcc_result_fields(result);
+    nrcc_buffer powers = nrcc_result_powers(result);
+    for (size_t r = 0; r < nrcc_result_count(result); r++) {
+        const double *p = element(positions, r);
+        const double *e = element(fields, r);
+        printf("%g, %g, %g: power %g, field x %g%+gj\n", p[0], p[1], p[2], *element(powers, r), e[0], e[1]);
+    }
+
+    nrcc_buffer pdp = nrcc_result_pdp(result, 1);
+    size_t strongest = 0;
+    for (size_t i = 0; i < pdp.length; i++) {
+        if (*element(pdp, i) > *element(pdp, strongest)) strongest = i;
+    }
+    printf("receiver 1 strongest delay bin: %zu\n", strongest);
+
+    nrcc_result_free(result);
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to choose the launch accuracy of Pole::transmit. Each scenario is traced at every accuracy from coarse
+// to dense, and each level reports its ray count and time with its worst field and power error, over the receivers,
+// against the densest level, the reference. The field error is |E - E_ref| / |E_ref| and the power error
+// |10 log10(P / P_ref)|, both in dB, with P the coherent power |E|^2. A receiver no ray reached counts as an infinite
+// error. The cheapest level whose power error meets the target is reported last.
+//
+// Scenarios are the eight element ring of test_array.cpp in free space, and a street canyon of metal walls over ground
+// traced to three bounces. The canyon runs at 150 MHz and one level denser than the ring: at 2.4 GHz its receivers
+// span several wavelengths, the coherent sum over the rays caught by each one still swings by decibels between the two
+// densest levels, and no reference is converged.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Nrcc.hpp"
+
+// Run is called as run(accuracy, receivers), traces into the receivers and returns the number of rays launched.
+template<typename Run>
+void converge(const std::string &name, const std::vector<Taps<double>> &rxs, const std::vector<uint64_t> &accuracies,
+              const double &target, Run &&run) {
+    using Taps = Taps<double>;
+    using VecC = Vec3<std::complex<double>>;
+
+    std::vector<std::vector<VecC>> fields;
+    std::vector<uint64_t> rays;
+    std::vector<int64_t> times;
+    for (const auto &accuracy: accuracies) {
+        std::vector<Taps> received = rxs;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        rays.push_back(run(accuracy, received));
+        auto stop = std::chrono::high_resolution_clock::now();
+
+        fields.push_back({});
+        for (const auto &receiver: received) fields.back().push_back(receiver.field());
+        times.push_back(duration_cast<std::chrono::microseconds>(stop - start).count());
+    }
+
+    auto power = [](const VecC &e) { return std::norm(e.x) + std::norm(e.y) + std::norm(e.z); };
+
+    const std::vector<VecC> &reference = fields.back();
+    uint64_t cheapest = accuracies.size() - 1;
+    std::cout << name << " accuracy " << accuracies.back() << ": " << rays.back() << " rays, " << times.back()
+              << " us, reference\n";
+    for (uint64_t l = accuracies.size() - 1; l-- > 0;) {
+        double field_error = -nrcc::infinity;
+        double power_error = 0;
+        for (uint64_t r = 0; r < rxs.size(); r++) {
+            double p = power(fields[l][r]);
+            double p_ref = power(reference[r]);
+            if (p_ref == 0) continue;
+
+            field_error = std::max(field_error, 10 * std::log10(power(fields[l][r] - reference[r]) / p_ref));
+            power_error = std::max(power_error, p > 0 ? std::abs(10 * std::log10(p / p_ref)) : nrcc::infinity);
+        }
+        if (power_error <= target) cheapest = l;
+
+        std::cout << name << " accuracy " << accuracies[l] << ": " << rays[l] << " rays, " << times[l] << " us, field "
+                  << field_error << " dB, power " << power_error << " dB\n";
+    }
+
+    if (cheapest == accuracies.size() - 1) {
+        std::cout << name << " cheapest within " << target << " dB: no level meets target\n";
+        return;
+    }
+    std::cout << name << " cheapest within " << target << " dB: accuracy " << accuracies[cheapest] << ", "
+              << rays[cheapest] << " rays\n";
+}
+
+int main() {
+    using Vec3 = Vec3<double>;
+    using Face = Face<double>;
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+
+    Nrcc<double> rt;
+    double target = 1;
+    std::vector<uint64_t> accuracies = {3, 4, 5, 6, 7, 8};
+
+    // RING
+    double frequency = 2.4e9;
+    double wavelength = nrcc::lightspeed / frequency;
+    std::vector<double> phases = {1.2022, 2.9025, 2.9025, 1.2022, -1.2022, -2.9025, -2.9025, -1.2022};
+
+    std::vector<Pole> ring;
+    for (int i = 0; i < 8; i++) {
+        Vec3 ang = {0, nrcc::pi / 4 * i + 0.3926991};
+        ring.push_back({ang * wavelength, {0, 0, 1}, frequency, 1});
+    }
+
+    std::vector<Taps> ring_rxs;
+    for (int i = 0; i < 16; i++) {
+        Vec3 ang = {0, nrcc::pi / 8 * i};
+        ring_rxs.push_back({{ang * 30, {0, 0, 1}, frequency, 1.5}, 1e-9, 500});
+    }
+
+    std::vector<Face> space;
+    converge("ring", ring_rxs, accuracies, target, [&](const uint64_t &accuracy, std::vector<Taps> &received) {
+        uint64_t rays = 0;
+        for (uint64_t i = 0; i < ring.size(); i++) {
+            std::vector<Wave> waves = ring[i].transmit(100000, phases[i], 2, accuracy);
+            for (Wave &wave: waves) rt.trace(wave, space, received, 0);
+            rays += waves.size();
+        }
+        return rays;
+    });
+
+    // CANYON
+    Mesh<double> canyon;
+    canyon.add({{{-200, 0, -15}, {200, 0, 15}, {200, 0, -15}, nrcc::ground},
+                {{-200, 0, -15}, {-200, 0, 15}, {200, 0, 15}, nrcc::ground},
+                {{-200, 0, -15}, {200, 0, -15}, {200, 30, -15}, nrcc::metal},
+                {{-200, 0, -15}, {200, 30, -15}, {-200, 30, -15}, nrcc::metal},
+                {{-200, 0, 15}, {200, 30, 15}, {200, 0, 15}, nrcc::metal},
+                {{-200, 0, 15}, {-200, 30, 15}, {200, 30, 15}, nrcc::metal}});
+
+    frequency = 1.5e8;
+    Pole tx = {{-100, 10, 0}, {0, 1, 0}, frequency, 1};
+
+    std::vector<Taps> canyon_rxs;
+    for (int i = 0; i < 10; i++) canyon_rxs.push_back({{{-50.0 + i * 20, 2, 5}, {0, 1, 0}, frequency, 4}, 1e-9, 2000});
+
+    converge("canyon", canyon_rxs, {4, 5, 6, 7, 8, 9}, target, [&](const uint64_t &accuracy, std::vector<Taps> &received) {
+        std::vector<Wave> waves = tx.transmit(1, 0, 2, accuracy);
+        for (Wave &wave: waves) rt.trace(wave, canyon, received, 3);
+        return waves.size();
+    });
+
+    return 0;
+}
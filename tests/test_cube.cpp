@@ -0,0 +1,90 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to check the first hit buffer in magnolia. Cube maps of growing resolution are built around the
+// transmitter, and the first hit of every launched ray is found from the buffer and from the mesh. Per resolution the
+// build time, the share of resolved texels, the lookup and intersection times and the number of rays whose hits differ
+// are reported; no hit should ever differ. The buffer is then looked up from several threads at once, and its statistics
+// must count every lookup. A full trace through the buffer is then compared with one through the mesh.
+
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Cube.hpp"
+#include "../src/Nrcc.hpp"
+
+int main() {
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+
+    double frequency = 2.4e9;
+
+    Mesh<double> mesh{read<double>((std::ifstream) "../data/magnolia.obj")};
+    mesh.add({{{-200, -40, -200}, {200, -40, 200}, {200, -40, -200}, nrcc::ground},
+              {{-200, -40, -200}, {-200, -40, 200}, {200, -40, 200}, nrcc::ground}});
+
+    Pole tx = {{-20, -10, 15}, {0, 1, 0}, frequency, 1};
+    std::vector<Wave> waves = tx.transmit(1, 0, 2, 7);
+
+    std::vector<Mesh<double>::Hit> exact;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const Wave &wave: waves) exact.push_back(mesh.intersect(wave.origin, wave.direct));
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << waves.size() << " rays, mesh: " << duration_cast<std::chrono::microseconds>(stop - start).count()
+              << " us\n";
+
+    for (uint64_t resolution = 32; resolution <= 512; resolution *= 2) {
+        start = std::chrono::high_resolution_clock::now();
+        Cube<double> cube{mesh, tx.coordinates, resolution};
+        stop = std::chrono::high_resolution_clock::now();
+        auto build = duration_cast<std::chrono::microseconds>(stop - start).count();
+
+        std::vector<Mesh<double>::Hit> found;
+        start = std::chrono::high_resolution_clock::now();
+        for (const Wave &wave: waves) found.push_back(cube.first(wave.origin, wave.direct));
+        stop = std::chrono::high_resolution_clock::now();
+
+        uint64_t differ = 0;
+        for (uint64_t i = 0; i < waves.size(); i++) {
+            bool miss = exact[i].distance == nrcc::infinity;
+            bool same = miss ? found[i].distance == nrcc::infinity :
+                        found[i].group == exact[i].group && found[i].index == exact[i].index &&
+                        found[i].distance == exact[i].distance;
+            differ += !same;
+        }
+        std::cout << "resolution " << resolution << ": build " << build << " us, " << cube.resolved() * 100
+                  << " % resolved, lookups " << duration_cast<std::chrono::microseconds>(stop - start).count()
+                  << " us, " << cube.hits << " from the buffer, " << differ << " differ\n";
+    }
+
+    Cube<double> shared{mesh, tx.coordinates, 64};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; t++) {
+        threads.emplace_back([&] {
+            for (const Wave &wave: waves) shared.first(wave.origin, wave.direct);
+        });
+    }
+    for (auto &thread: threads) thread.join();
+    std::cout << "8 threads: " << shared.hits + shared.misses << " lookups counted of " << 8 * waves.size() << "\n";
+
+    std::vector<Taps> rxs;
+    for (int i = 0; i < 10; i++) rxs.push_back({{{150, 20, -100.0 + i * 20}, {0, 1, 0}, frequency, 4}, 1e-9, 2000});
+
+    Nrcc<double> rt;
+    Cube<double> cube{mesh, tx.coordinates, 256};
+    std::vector<Taps> buffered = rxs;
+    std::vector<Taps> plain = rxs;
+    for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, cube, buffered, 2);
+    for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, mesh, plain, 2);
+
+    double error = 0;
+    for (uint64_t r = 0; r < rxs.size(); r++) {
+        error = std::max(error, (buffered[r].field() - plain[r].field()).real().norm());
+    }
+    std::cout << "trace difference " << error << "\n";
+
+    return 0;
+}
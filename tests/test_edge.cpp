@@ -0,0 +1,179 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to check edge diffraction. The transition function is compared against a direct quadrature of its
+// Fresnel integral. A perfectly conducting half plane screen is lit from a point source, and the soft and hard
+// coefficients of its edge around the Keller cone are compared against the closed form UTD coefficients of a half
+// plane, D = -e^(-j pi / 4) / (2 sqrt(2 pi k) sin b) * (F(kL a(p - p')) / cos((p - p') / 2) -+ F(kL a(p + p')) /
+// cos((p + p') / 2)) with a(x) = 2 cos^2(x / 2), across both shadow boundaries. The diffracted waves must leave from
+// the edge and carry the incident field times those coefficients. Finally magnolia is traced with and without wedges,
+// and the receivers out of sight of the transmitter that any wave reaches are counted.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Nrcc.hpp"
+#include "../src/Pole.hpp"
+
+int main() {
+    using cmpx = std::complex<double>;
+    using VecC = Vec3<cmpx>;
+    using Vec3 = Vec3<double>;
+    using Face = Face<double>;
+    using Wave = Wave<double>;
+    using Edge = Edge<double>;
+    using Pole = Pole<double>;
+
+    // TRANSITION FUNCTION
+    // F(x) = 2j sqrt(x) e^(jx) (sqrt(pi) / 2 e^(-j pi / 4) - int_0^sqrt(x) e^(-j t^2) dt), integrated by Simpson.
+    double worst_transition = 0;
+    for (double x: {1e-3, 0.01, 0.1, 0.5, 1.0, 2.0, 5.0, 10.0, 15.0, 20.0}) {
+        uint64_t n = 20000;
+        double h = std::sqrt(x) / n;
+        cmpx integral = 0;
+        for (uint64_t i = 0; i <= n; i++) {
+            double w = i == 0 || i == n ? 1 : i % 2 ? 4 : 2;
+            integral += w * std::exp(cmpx(0, -(i * h) * (i * h)));
+        }
+        integral *= h / 3;
+        cmpx exact = cmpx(0, 2) * std::sqrt(x) * std::exp(cmpx(0, x)) *
+                     (std::sqrt(nrcc::pi) / 2 * std::exp(cmpx(0, -nrcc::pi / 4)) - integral);
+        worst_transition = std::max(worst_transition, std::abs(nrcc::transition(x) - exact) / std::abs(exact));
+    }
+    std::cout << "transition function, largest relative difference from quadrature: " << worst_transition << "\n";
+
+    // HALF PLANE
+    // A near perfect conductor, so the reflection weights of both faces are -1 soft and +1 hard.
+    nrcc::conductivity[nrcc::metal] = {1e30, 0};
+
+    double frequency = 2.4e9;
+    double k = 2 * nrcc::pi * frequency / nrcc::lightspeed;
+
+    // Screen below the x axis in the plane z = 0, its free top edge along x.
+    std::vector<Face> screen = {{{-50, -100, 0}, {50, -100, 0}, {50, 0, 0}, nrcc::metal},
+                                {{-50, -100, 0}, {50, 0, 0}, {-50, 0, 0}, nrcc::metal}};
+    Wedges<double> wedges(screen, 0.5);
+
+    Nrcc<double> rt;
+    rt.keller_rays = 360;
+
+    std::cout << "half plane, " << wedges.edges.size() << " edges\n";
+
+    for (const Vec3 &source: {Vec3{0, 6, 8}, Vec3{0, -3, 10}, Vec3{4, 6, -8}}) {
+        // Aimed just off the edge, within the capture radius.
+        Vec3 aim = {0, 0.3, 0.2};
+        for (int s = 0; s < 2; s++) {
+            Vec3 polar = s == 0 ? Vec3{1, 0, 0} : cross(Vec3{1, 0, 0}, (aim - source).unit());
+            Wave incident = {source, (aim - source).unit(), frequency, 1, 0, polar.cmpx()};
+
+            Edge *hit = nullptr;
+            double t = 0;
+            wedges.near(incident.origin, incident.direct, 1e3, [&](Edge &edge, const double &d) {
+                if (std::fabs(edge.points[0].y) < 1e-9 && std::fabs(edge.points[1].y) < 1e-9) {
+                    hit = &edge;
+                    t = d;
+                }
+            });
+            if (hit == nullptr) {
+                std::cout << "edge not found from " << source << "\n";
+                continue;
+            }
+
+            std::vector<Wave> diffracted = rt.diffractedWaves(incident, *hit, t);
+
+            double off_edge = 0;
+            double worst_coefficient = 0;
+            double worst_field = 0;
+            for (Wave &wave: diffracted) {
+                off_edge = std::max(off_edge, std::hypot(wave.origin.y, wave.origin.z));
+
+                Vec3 si = (wave.origin - source).unit();
+                Vec3 sd = wave.direct.unit();
+                double sin_b = cross(si, hit->direct()).norm();
+                double p_i = hit->angle(si * -1);
+                double p_d = hit->angle(sd);
+                double L = range(source, wave.origin) * sin_b * sin_b;
+
+                auto a = [](const double &x) { return 2 * std::cos(x / 2) * std::cos(x / 2); };
+                cmpx scale = -std::exp(cmpx(0, -nrcc::pi / 4)) / (2 * std::sqrt(2 * nrcc::pi * k) * sin_b);
+                cmpx minus = nrcc::transition(k * L * a(p_d - p_i)) / std::cos((p_d - p_i) / 2);
+                cmpx plus = nrcc::transition(k * L * a(p_d + p_i)) / std::cos((p_d + p_i) / 2);
+                std::array<cmpx, 2> closed = {scale * (minus - plus), scale * (minus + plus)};
+
+                // Directions within a degree of a shadow boundary are left to the nudge in Edge::term.
+                double boundary = std::min(std::fabs(std::fabs(p_d - p_i) - nrcc::pi),
+                                           std::fabs(std::fabs(p_d + p_i) - nrcc::pi));
+                if (boundary < nrcc::pi / 180) continue;
+
+                std::array<cmpx, 2> d = hit->coefficients(si, sd, frequency, range(source, wave.origin));
+                for (int c = 0; c < 2; c++) {
+                    worst_coefficient = std::max(worst_coefficient, std::abs(d[c] - closed[c]) / std::abs(closed[c]));
+                }
+
+                // The incident field splits along the edge fixed unit vectors beta and phi, soft and hard, and the
+                // diffracted field along their orthogonal counterparts.
+                Vec3 phi = cross(hit->direct(), si).unit();
+                Vec3 beta = cross(phi, si);
+                VecC ei = incident.electricField(range(source, wave.origin));
+                VecC ed = wave.electricField(0);
+                double expected = std::hypot(std::abs(closed[0] * dot(ei, beta)), std::abs(closed[1] * dot(ei, phi)));
+                double found = std::sqrt(std::norm(ed.x) + std::norm(ed.y) + std::norm(ed.z));
+                worst_field = std::max(worst_field, std::fabs(found - expected) / expected);
+            }
+
+            std::cout << "  source " << source << (s == 0 ? " along edge" : " across edge") << ": " << diffracted.size()
+                      << " rays, farthest origin from edge " << off_edge << ", largest relative difference "
+                      << worst_coefficient << " in coefficients and " << worst_field << " in fields\n";
+        }
+    }
+
+    nrcc::conductivity[nrcc::metal] = {10.0e7, 0};
+
+    // MAGNOLIA
+    std::vector<Face> faces{read<double>((std::ifstream) "../data/magnolia.obj")};
+    Mesh<double> mesh{faces};
+    Wedges<double> city(faces, 0.5);
+
+    Vec3 tx = {-150, 30, 120};
+    std::vector<Vec3> shadowed;
+    for (int i = -20; i <= 20; i++) {
+        for (int j = -20; j <= 20; j++) {
+            Vec3 rx = {i * 4.0, -38, j * 4.0};
+            if (mesh.occluded(tx, rx)) shadowed.push_back(rx);
+        }
+    }
+
+    std::cout << "magnolia, " << city.edges.size() << " edges, " << shadowed.size() << " receivers out of sight\n";
+
+    Nrcc<double> street;
+    for (int w = 0; w < 2; w++) {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        std::vector<Wave> launch = Pole{tx, {0, 1, 0}, 2.4e9, 1}.transmit(1, 0, 2, 4);
+        std::vector<Wave> waves;
+        for (Wave &wave: launch) {
+            std::vector<Wave> traced = w == 0 ? street.trace(wave, mesh, 2) : street.trace(wave, mesh, city, 2);
+            waves.insert(waves.end(), traced.begin(), traced.end());
+        }
+
+        auto stop = std::chrono::high_resolution_clock::now();
+
+        uint64_t reached = 0;
+        for (const auto &rx: shadowed) {
+            for (const auto &wave: waves) {
+                double d = nrcc::intersectionDistance(wave.origin, wave.direct, rx, 2.0);
+                if (d > 0 && d < mesh.intersect(wave.origin, wave.direct).distance) {
+                    reached++;
+                    break;
+                }
+            }
+        }
+
+        std::cout << (w == 0 ? "  without wedges: " : "  with wedges: ") << waves.size() << " waves in "
+                  << duration_cast<std::chrono::milliseconds>(stop - start).count() << " ms, " << reached << " of "
+                  << shadowed.size() << " receivers out of sight reached\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,143 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to check material edits in magnolia. The building face met by the most received paths, then the twenty
+// faces met by the most, are turned to glass, then to metal, then back to concrete. After each edit the receivers are
+// compared against a full trace of the edited scene, and the time of the edit against the time of that trace. Turning
+// the faces back should restore the first fields. Contributions dropped for lack of taps are compared with the full
+// trace too, also in receivers with few taps, and a tap emptied by an edit must be free for a new contribution. Finally
+// the twenty faces are toggled between glass and concrete many times, and the paths and events kept must stay bounded.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Nrcc.hpp"
+#include "../src/Edit.hpp"
+
+int main() {
+    using Vec3 = Vec3<double>;
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+
+    double frequency = 2.4e9;
+
+    Mesh<double> mesh{read<double>((std::ifstream) "../data/magnolia.obj")};
+    mesh.add({{{-200, -40, -200}, {200, -40, 200}, {200, -40, -200}, nrcc::ground},
+              {{-200, -40, -200}, {-200, -40, 200}, {200, -40, 200}, nrcc::ground}});
+
+    Pole tx = {{-20, -10, 15}, {0, 1, 0}, frequency, 1};
+    std::vector<Taps> rxs;
+    for (int i = 0; i < 10; i++) {
+        for (int k = 0; k < 10; k++) {
+            rxs.push_back({{{-90.0 + i * 20, -25, -90.0 + k * 20}, {0, 1, 0}, frequency, 4}, 1e-9, 2000});
+        }
+    }
+
+    std::vector<Taps> received = rxs;
+    Edit<double> edit{mesh, received};
+
+    auto start = std::chrono::high_resolution_clock::now();
+    edit.trace(tx.transmit(1, 0, 2, 5), 3);
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "trace: " << edit.records.size() << " paths, "
+              << duration_cast<std::chrono::microseconds>(stop - start).count() << " us\n";
+
+    std::map<uint64_t, uint64_t> counts;
+    for (const auto &record: edit.records) {
+        for (const auto &id: std::set<uint64_t>(record.faces.begin(), record.faces.end())) counts[id]++;
+    }
+    std::vector<std::pair<uint64_t, uint64_t>> ranked;
+    for (const auto &[id, count]: counts) {
+        if (id < mesh.groups[0].faces.size()) ranked.push_back({count, id});
+    }
+    std::sort(ranked.rbegin(), ranked.rend());
+
+    std::vector<Vec3> first;
+    for (const auto &receiver: received) first.push_back(receiver.field().real());
+
+    Nrcc<double> rt;
+    for (uint64_t size: {1, 20}) {
+        std::vector<uint64_t> facade;
+        for (uint64_t i = 0; i < std::min<uint64_t>(size, ranked.size()); i++) facade.push_back(ranked[i].second);
+
+        for (auto material: {nrcc::glass, nrcc::metal, nrcc::concrete}) {
+            start = std::chrono::high_resolution_clock::now();
+            edit.change(facade, material);
+            stop = std::chrono::high_resolution_clock::now();
+            auto incremental = duration_cast<std::chrono::microseconds>(stop - start).count();
+
+            std::vector<Taps> full = rxs;
+            start = std::chrono::high_resolution_clock::now();
+            for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, mesh, full, 3);
+            stop = std::chrono::high_resolution_clock::now();
+            auto retrace = duration_cast<std::chrono::microseconds>(stop - start).count();
+
+            double error = 0;
+            double scale = 0;
+            double restored = 0;
+            uint64_t dropped = 0;
+            uint64_t retraced_dropped = 0;
+            for (uint64_t r = 0; r < rxs.size(); r++) {
+                Vec3 e = full[r].field().real();
+                error = std::max(error, (received[r].field().real() - e).norm());
+                scale = std::max(scale, e.norm());
+                restored = std::max(restored, (received[r].field().real() - first[r]).norm());
+                dropped += received[r].dropped;
+                retraced_dropped += full[r].dropped;
+            }
+            std::cout << size << " faces to material " << material << ": " << edit.reevaluated
+                      << " paths re-evaluated, " << edit.retraced << " subtrees retraced, " << incremental
+                      << " us against " << retrace << " us, difference " << error << " of " << scale
+                      << ", from the first fields " << restored << ", " << dropped << " dropped against "
+                      << retraced_dropped << "\n";
+        }
+    }
+
+    std::vector<uint64_t> facade;
+    for (uint64_t i = 0; i < std::min<uint64_t>(20, ranked.size()); i++) facade.push_back(ranked[i].second);
+
+    // Receivers with few taps, so that contributions taken back must free them for the regrown ones.
+    std::vector<Taps> small;
+    for (const auto &rx: rxs) small.push_back({rx.pole, 1e-9, 2000, 8, 4});
+    std::vector<Taps> narrow = small;
+    Edit<double> tight{mesh, narrow};
+    tight.trace(tx.transmit(1, 0, 2, 5), 3);
+    tight.change(facade, nrcc::metal);
+
+    std::vector<Taps> full = small;
+    for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, mesh, full, 3);
+    uint64_t taps = 0;
+    uint64_t retraced_taps = 0;
+    uint64_t dropped = 0;
+    uint64_t retraced_dropped = 0;
+    for (uint64_t r = 0; r < rxs.size(); r++) {
+        taps += narrow[r].taps.size();
+        retraced_taps += full[r].taps.size();
+        dropped += narrow[r].dropped;
+        retraced_dropped += full[r].dropped;
+    }
+    std::cout << "4 taps per receiver, 20 faces to metal: " << taps << " taps against " << retraced_taps << ", "
+              << dropped << " dropped against " << retraced_dropped << "\n";
+    tight.change(facade, nrcc::concrete);
+
+    // A tap whose only contribution is taken back must make room for another.
+    Taps single = {tx, 1e-9, 2000, 8, 1};
+    Vec3 up = {0, 1, 0};
+    Vec3 down = {0, -1, 0};
+    bool kept = single.add({1, 0, 0}, 30, up, up);
+    single.remove({1, 0, 0}, 30, up, up, kept);
+    kept = single.add({1, 0, 0}, 60, down, down);
+    std::cout << "1 tap, contribution taken back and another added: " << (kept ? "kept" : "dropped") << ", "
+              << single.taps.size() << " taps, " << single.dropped << " dropped\n";
+    for (int round = 1; round <= 40; round++) {
+        edit.change(facade, round % 2 ? nrcc::glass : nrcc::concrete);
+        if (round % 10 == 0) {
+            std::cout << round << " toggles: " << edit.records.size() << " paths, " << edit.events.size()
+                      << " events kept\n";
+        }
+    }
+
+    return 0;
+}
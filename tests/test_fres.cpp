@@ -0,0 +1,101 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to check the Fresnel tables. Every material pair is tabulated at 2.4 GHz and checked against the exact
+// coefficients at random angles, including the intervals left to exact evaluation. A lookup is then timed against the
+// exact evaluation. Finally magnolia is traced with the default tolerance and with a near exact one, and the received
+// fields compared, along with the number of tables the trace actually built.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Nrcc.hpp"
+
+int main() {
+    using Fres = Fres<double>;
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+
+    double frequency = 2.4e9;
+    Rand generator{3};
+
+    std::vector<double> angles;
+    for (int i = 0; i < 1000000; i++) angles.push_back(generator.uniform());
+
+    for (int a = nrcc::vacuum; a <= nrcc::swamp; a++) {
+        for (int b = nrcc::concrete; b <= nrcc::swamp; b++) {
+            auto from = static_cast<nrcc::Materials>(a);
+            auto to = static_cast<nrcc::Materials>(b);
+            const Fres &table = Fres::table(from, to, frequency);
+
+            std::complex<double> n1 = nrcc::refractiveIndex(from, frequency);
+            std::complex<double> n2 = nrcc::refractiveIndex(to, frequency);
+
+            uint64_t unresolved = std::count(table.unresolved.begin(), table.unresolved.end(), true);
+
+            double worst = 0;
+            for (int i = 0; i < 10000; i++) {
+                Fres::Coefficients c = table(angles[i]);
+                Fres::Coefficients e = Fres::exact(n1, n2, angles[i]);
+                for (int k = 0; k < 4; k++) worst = std::max(worst, std::abs(c[k] - e[k]));
+            }
+            std::cout << a << " to " << b << ": " << table.samples.size() << " samples, " << unresolved
+                      << " unresolved, error " << table.error << ", worst sampled " << worst << "\n";
+        }
+    }
+
+    const Fres &glass = Fres::table(nrcc::vacuum, nrcc::glass, frequency);
+    std::complex<double> n1 = 1;
+    std::complex<double> n2 = nrcc::refractiveIndex(nrcc::glass, frequency);
+    std::complex<double> sum = 0;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (const auto &angle: angles) sum += Fres::exact(n1, n2, angle)[0];
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "exact time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+    start = std::chrono::high_resolution_clock::now();
+    for (const auto &angle: angles) sum -= glass(angle)[0];
+    stop = std::chrono::high_resolution_clock::now();
+    std::cout << "table time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << ", difference "
+              << std::abs(sum) / angles.size() << "\n";
+
+    Mesh<double> mesh{read<double>((std::ifstream) "../data/magnolia.obj")};
+    mesh.add({{{-200, -40, -200}, {200, -40, 200}, {200, -40, -200}, nrcc::ground},
+              {{-200, -40, -200}, {-200, -40, 200}, {200, -40, 200}, nrcc::ground}});
+
+    Pole tx = {{-150, 30, 120}, {0, 1, 0}, frequency, 1};
+    std::vector<Taps> rxs;
+    for (int i = 0; i < 10; i++) rxs.push_back({{{150, 20, -100.0 + i * 20}, {0, 1, 0}, frequency, 4}, 1e-9, 2000});
+
+    Nrcc<double> rt;
+    auto run = [&](const double &tolerance, const uint64_t &limit) {
+        Fres::clear();
+        Fres::tolerance = tolerance;
+        Fres::limit = limit;
+
+        std::vector<Taps> received = rxs;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, mesh, received, 2);
+        auto stop = std::chrono::high_resolution_clock::now();
+        std::cout << "tolerance " << tolerance << ": " << duration_cast<std::chrono::microseconds>(stop - start).count()
+                  << " us, " << Fres::size() << " tables\n";
+        return received;
+    };
+
+    std::vector<Taps> near_exact = run(1e-10, 1 << 22);
+    std::vector<Taps> tabled = run(1e-4, 1 << 12);
+
+    double error = 0;
+    double scale = 0;
+    for (uint64_t r = 0; r < rxs.size(); r++) {
+        auto e = near_exact[r].field();
+        error = std::max(error, (tabled[r].field() - e).real().norm());
+        scale = std::max(scale, e.real().norm());
+    }
+    std::cout << "default vs near exact: " << error << " of " << scale << "\n";
+
+    return 0;
+}
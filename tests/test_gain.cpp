@@ -0,0 +1,113 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to compare uniform and importance sampled launches from a sector antenna aimed at a row of receivers.
+// The coherent field at each receiver should agree, with the importance sampled run using far fewer rays. Incoherent
+// per ray power is not compared, as it depends on how many rays each receiver catches. A pole without a pattern falls
+// back to a stratified dipole launch, which should agree with a uniform one. Malformed patterns should be rejected with
+// an error, and leave an empty pattern that launches no waves.
+
+#include <fstream>
+#include <chrono>
+#include <filesystem>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Gain.hpp"
+#include "../src/Nrcc.hpp"
+
+int main() {
+    using Vec3 = Vec3<double>;
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+
+    Mesh<double> mesh{read<double>((std::ifstream) "../data/magnolia.obj")};
+    mesh.add({{{-200, -40, -200}, {200, -40, 200}, {200, -40, -200}, nrcc::ground},
+              {{-200, -40, -200}, {-200, -40, 200}, {200, -40, 200}, nrcc::ground}});
+
+    // 65 by 10 degree sector, 30 dB front to back, boresight along +x with y up.
+    Gain<double> sector = Gain<double>::sector(65 * nrcc::pi / 180, 10 * nrcc::pi / 180, 30, 17);
+    sector.axis = {0, 1, 0};
+    sector.reference = {1, 0, 0};
+
+    Pole tx = {{-150, 30, 0}, {0, 1, 0}, 2.4e9, 1};
+    tx.pattern = &sector;
+
+    std::vector<Taps> rxs;
+    for (int i = 0; i < 10; i++) {
+        rxs.push_back({{{150, 20, -100.0 + i * 20}, {0, 1, 0}, 2.4e9, 4}, 1e-9, 2000});
+    }
+
+    Nrcc<double> rt;
+    auto run = [&](const std::string &name, std::vector<Wave> waves) {
+        std::vector<Taps> received = rxs;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (Wave &wave: waves) rt.trace(wave, mesh, received, 2);
+        auto stop = std::chrono::high_resolution_clock::now();
+        std::cout << name << ": " << waves.size() << " rays, "
+                  << duration_cast<std::chrono::microseconds>(stop - start).count() << " us\n";
+
+        std::vector<double> powers;
+        for (const auto &receiver: received) {
+            auto e = receiver.field();
+            powers.push_back(std::norm(e.x) + std::norm(e.y) + std::norm(e.z));
+        }
+        return powers;
+    };
+
+    Rand generator{7};
+    std::vector<double> uniform = run("uniform", tx.transmit(1, 0, 0, nrcc::fibonacci<double>(163842)));
+    std::vector<double> sampled = run("importance", tx.transmit(1, 0, 163842, generator));
+    std::vector<double> fewer = run("importance, 1/8", tx.transmit(1, 0, 163842 / 8, generator));
+
+    for (uint64_t r = 0; r < rxs.size(); r++) {
+        std::cout << rxs[r].pole.coordinates << ": " << 10 * std::log10(uniform[r]) << " dB uniform, "
+                  << 10 * std::log10(sampled[r]) << " dB importance, " << 10 * std::log10(fewer[r])
+                  << " dB importance 1/8\n";
+    }
+
+    Pole dipole = {{-150, 30, 0}, {0, 1, 0}, 2.4e9, 1};
+    std::vector<double> plain = run("dipole uniform", dipole.transmit(1, 0, 2, nrcc::fibonacci<double>(163842)));
+    std::vector<double> fallback = run("dipole stratified", dipole.transmit(1, 0, 163842, generator));
+
+    // Single receivers sit on interference ripples that depend on which rays land, so the row is compared as a whole.
+    double a = 0;
+    double b = 0;
+    for (uint64_t r = 0; r < rxs.size(); r++) {
+        a += plain[r];
+        b += fallback[r];
+    }
+    std::cout << "dipole without pattern, row power " << 10 * std::log10(a / rxs.size()) << " dB uniform, "
+              << 10 * std::log10(b / rxs.size()) << " dB stratified\n";
+
+    Vec3 boresight = {1, 0, 0};
+    std::cout << "boresight gain: " << 10 * std::log10(sector.gain(boresight)) << " dBi, back: "
+              << 10 * std::log10(sector.gain(boresight * -1)) << " dBi, polarization: "
+              << sector.polarization(boresight).real() << "\n";
+
+    auto load = [](const std::string &text) {
+        std::ofstream("../data/pattern.txt") << text;
+        return Gain<double>::read((std::ifstream) "../data/pattern.txt");
+    };
+    std::vector<Gain<double>> rejected = {
+            Gain<double>::read((std::ifstream) "../data/missing.txt"),
+            load("0 0 1 0 0 0\n0 180 1 0 0 0\n"),
+            load("0 0 1 0 0 0\n0 180 1 0 0 0\n180 0 1 0 0 0\n"),
+            load("0 0 1 0 0 0\n0 180 1 0 0 0\n180 180 1 0 0 0\n180 0 1 0 0 0\n"),
+            load("0 0 1 0 0 0\n0 180 1 0\n"),
+            {3, 4, std::vector<std::array<std::complex<double>, 2>>(11)},
+    };
+    Gain<double> grid = load("0 0 1 0 0 0\n0 180 1 0 0 0\n180 0 1 0 0 0\n180 180 1 0 0 0\n");
+    std::filesystem::remove("../data/pattern.txt");
+
+    for (const auto &pattern: rejected) {
+        Pole rejected_tx = {{-150, 30, 0}, {0, 1, 0}, 2.4e9, 1};
+        rejected_tx.pattern = &pattern;
+        std::cout << "rejected pattern: empty " << pattern.empty() << ", gain " << pattern.gain(boresight) << ", "
+                  << rejected_tx.transmit(1, 0, 0, nrcc::fibonacci<double>(1000)).size() << " uniform and "
+                  << rejected_tx.transmit(1, 0, 1000, generator).size() << " importance waves\n";
+    }
+    std::cout << "2 by 2 pattern: empty " << grid.empty() << ", gain " << grid.gain(boresight) << "\n";
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to check instancing on growing grids of magnolia copies, each turned, scaled and every third one made
+// of metal. The grid is traced once as instances and once expanded into a plain mesh, and the receivers compared. Per
+// grid the stored faces, build times and trace times of both are reported: the instanced build and face count should
+// not grow with the number of copies. Finally a placement that flattens its prototype must be rejected.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Inst.hpp"
+#include "../src/Nrcc.hpp"
+
+int main() {
+    using Vec3 = Vec3<double>;
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+    using Inst = Inst<double>;
+
+    double frequency = 2.4e9;
+    std::vector<Face<double>> magnolia = read<double>((std::ifstream) "../data/magnolia.obj");
+
+    Pole tx = {{10, 60, 10}, {0, 1, 0}, frequency, 1};
+
+    Nrcc<double> rt;
+    for (int side = 1; side <= 8; side *= 2) {
+        auto start = std::chrono::high_resolution_clock::now();
+        Inst inst;
+        uint64_t prototype = inst.add(magnolia);
+        for (int i = 0; i < side; i++) {
+            for (int k = 0; k < side; k++) {
+                int n = i * side + k;
+                std::optional<nrcc::Materials> material;
+                if (n % 3 == 2) material = nrcc::metal;
+                inst.place(prototype, Inst::turn(n * 0.7, 0.4 + 0.05 * (n % 4)),
+                           {(i - (side - 1) / 2.0) * 100, 0, (k - (side - 1) / 2.0) * 100}, material);
+            }
+        }
+        uint64_t ground = inst.add({{{-500, -20, -500}, {500, -20, 500}, {500, -20, -500}, nrcc::ground},
+                                    {{-500, -20, -500}, {-500, -20, 500}, {500, -20, 500}, nrcc::ground}});
+        inst.place(ground, Inst::turn(0), {0, 0, 0});
+        inst.build();
+        auto stop = std::chrono::high_resolution_clock::now();
+        auto inst_build = duration_cast<std::chrono::microseconds>(stop - start).count();
+
+        uint64_t stored = 0;
+        for (const auto &prototype_mesh: inst.prototypes) stored += prototype_mesh.size();
+
+        start = std::chrono::high_resolution_clock::now();
+        std::vector<std::vector<Vec3>> polygons;
+        std::vector<Face<double>> expanded = inst.expand(polygons);
+        Mesh<double> mesh{expanded};
+        stop = std::chrono::high_resolution_clock::now();
+        auto mesh_build = duration_cast<std::chrono::microseconds>(stop - start).count();
+
+        std::vector<Taps> rxs;
+        for (int i = 0; i < 10; i++) rxs.push_back({{{-240.0 + i * 50, 5, 30}, {0, 1, 0}, frequency, 4}, 1e-9, 2000});
+
+        std::vector<Taps> instanced = rxs;
+        start = std::chrono::high_resolution_clock::now();
+        for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, inst, instanced, 3);
+        stop = std::chrono::high_resolution_clock::now();
+        auto inst_trace = duration_cast<std::chrono::microseconds>(stop - start).count();
+
+        std::vector<Taps> plain = rxs;
+        start = std::chrono::high_resolution_clock::now();
+        for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, mesh, plain, 3);
+        stop = std::chrono::high_resolution_clock::now();
+        auto mesh_trace = duration_cast<std::chrono::microseconds>(stop - start).count();
+
+        double error = 0;
+        double scale = 0;
+        uint64_t count = 0;
+        for (uint64_t r = 0; r < rxs.size(); r++) {
+            Vec3 e = plain[r].field().real();
+            error = std::max(error, (instanced[r].field().real() - e).norm());
+            scale = std::max(scale, e.norm());
+            count += plain[r].count;
+        }
+
+        std::cout << side * side << " copies: instanced " << stored << " faces, build " << inst_build << " us, trace "
+                  << inst_trace << " us, " << inst.made() << " faces made; expanded " << expanded.size()
+                  << " faces, build " << mesh_build << " us, trace " << mesh_trace << " us; " << count
+                  << " receptions, difference " << error << " of " << scale << "\n";
+    }
+
+    Inst flat;
+    uint64_t prototype = flat.add(magnolia);
+    uint64_t placed = flat.place(prototype, {Vec3{1, 0, 0}, Vec3{0, 0, 0}, Vec3{0, 0, 1}}, {0, 0, 0});
+    std::cout << "flattening placement rejected: " << (placed == Inst::none) << ", instances: " << flat.instances.size()
+              << "\n";
+
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to check sharded runs. The same job is traced in one process and split over worker processes, then
+// one shard file is deleted to simulate a crash and the job is resumed. All results should agree. Finally jobs that
+// differ in accuracy, a transmitter, a receiver or the mesh are pointed at the same directory, and none of the shards
+// left there may count as theirs.
+
+#include <fstream>
+#include <chrono>
+#include <filesystem>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Jobs.hpp"
+
+int main() {
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+
+    Mesh<double> mesh{read<double>((std::ifstream) "../data/magnolia.obj")};
+    mesh.add({{{-200, -40, -200}, {200, -40, 200}, {200, -40, -200}, nrcc::ground},
+              {{-200, -40, -200}, {-200, -40, 200}, {200, -40, 200}, nrcc::ground}});
+
+    std::vector<Pole> txs = {{{-150, 30, 120}, {0, 1, 0}, 2.4e9, 1},
+                             {{-150, 30, -120}, {0, 1, 0}, 2.4e9, 1}};
+
+    std::vector<Taps> rxs;
+    for (int i = 0; i < 10; i++) {
+        rxs.push_back({{{150, 20, -100.0 + i * 20}, {0, 1, 0}, 2.4e9, 4}, 1e-9, 2000});
+    }
+
+    std::filesystem::create_directories("../data/shards");
+    for (const auto &entry: std::filesystem::directory_iterator("../data/shards")) {
+        std::filesystem::remove(entry.path());
+    }
+
+    // SINGLE PROCESS
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<Taps> single = rxs;
+    Nrcc<double> rt;
+    for (auto &tx: txs) {
+        std::vector<Wave> waves = tx.transmit(1, 0, 2, 5);
+        for (Wave &wave: waves) rt.trace(wave, mesh, single, 2);
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "single time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+    // SHARDED
+    start = std::chrono::high_resolution_clock::now();
+    Jobs<double> jobs{mesh, txs, rxs, "../data/shards", 8};
+    jobs.accuracy = 5;
+    jobs.run(4);
+    bool merged = jobs.merge();
+    stop = std::chrono::high_resolution_clock::now();
+    std::cout << "sharded time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+    std::cout << "merged: " << merged << ", waves: " << jobs.launched << "\n";
+
+    std::vector<Taps> first = jobs.receivers;
+
+    // RESUME AFTER LOSING A SHARD
+    std::filesystem::remove(jobs.file(3));
+    Jobs<double> resumed{mesh, txs, rxs, "../data/shards", 8};
+    resumed.accuracy = 5;
+    uint64_t pending = 0;
+    for (uint64_t shard = 0; shard < resumed.shards; shard++) pending += !resumed.done(shard);
+    resumed.run(4);
+    resumed.merge();
+    std::cout << "shards rerun: " << pending << "\n";
+
+    double single_error = 0;
+    double resume_error = 0;
+    for (uint64_t r = 0; r < rxs.size(); r++) {
+        single_error = std::max(single_error, (single[r].field() - first[r].field()).real().norm());
+        resume_error = std::max(resume_error, (resumed.receivers[r].field() - first[r].field()).real().norm());
+        std::cout << first[r].pole.coordinates << ": " << first[r].count << " waves, "
+                  << first[r].delaySpread() * 1e9 << " ns rms\n";
+    }
+    std::cout << "single vs sharded: " << single_error << "\n";
+    std::cout << "sharded vs resumed: " << resume_error << "\n";
+
+    // STALE SHARDS
+    Mesh<double> edited = mesh;
+    edited.face(0).material = nrcc::metal;
+
+    std::vector<Pole> moved_txs = txs;
+    moved_txs[1].coordinates.x += 1;
+    std::vector<Taps> moved_rxs = rxs;
+    moved_rxs[0].pole.coordinates.y += 1;
+
+    std::vector<std::pair<std::string, Jobs<double>>> others = {
+            {"accuracy", {mesh, txs, rxs, "../data/shards", 8}},
+            {"transmitter", {mesh, moved_txs, rxs, "../data/shards", 8}},
+            {"receiver", {mesh, txs, moved_rxs, "../data/shards", 8}},
+            {"mesh", {edited, txs, rxs, "../data/shards", 8}}};
+    for (auto &[name, other]: others) {
+        other.accuracy = name == "accuracy" ? 4 : 5;
+
+        uint64_t reused = 0;
+        for (uint64_t shard = 0; shard < other.shards; shard++) reused += other.done(shard);
+        std::cout << "changed " << name << ": " << reused << " shards reused, merge " << other.merge() << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to benchmark the policy specialized trace kernels against the generic streaming trace. The kernel with
+// the generic configuration must reproduce the generic trace exactly; the reduced ones trade interactions for time.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Nrcc.hpp"
+
+int main() {
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+
+    Mesh<double> mesh{read<double>((std::ifstream) "../data/magnolia.obj")};
+    mesh.add({{{-200, -40, -200}, {200, -40, 200}, {200, -40, -200}, nrcc::ground},
+              {{-200, -40, -200}, {-200, -40, 200}, {200, -40, 200}, nrcc::ground}});
+
+    Pole tx = {{-150, 30, 120}, {0, 1, 0}, 2.4e9, 1};
+
+    std::vector<Taps> rxs;
+    for (int i = 0; i < 10; i++) {
+        rxs.push_back({{{150, 20, -100.0 + i * 20}, {0, 1, 0}, 2.4e9, 4}, 1e-9, 2000});
+    }
+
+    auto run = [&](const std::string &name, auto &&tracer) {
+        std::vector<Taps> received = rxs;
+        std::vector<Wave> waves = tx.transmit(1, 0, 2, 6);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (Wave &wave: waves) tracer(wave, received);
+        auto stop = std::chrono::high_resolution_clock::now();
+
+        uint64_t count = 0;
+        for (const auto &receiver: received) count += receiver.count;
+        std::cout << name << ": " << duration_cast<std::chrono::microseconds>(stop - start).count() << " us, "
+                  << count << " received\n";
+        return received;
+    };
+
+    Nrcc<double> generic;
+    Nrcc<double, nrcc::Policy<2>> full;
+    Nrcc<double, nrcc::Specular> specular;
+    Nrcc<double, nrcc::SingleBounce> single;
+
+    std::vector<Taps> a = run("generic", [&](Wave &w, std::vector<Taps> &r) { generic.trace(w, mesh, r, 2); });
+    std::vector<Taps> b = run("policy<2>", [&](Wave &w, std::vector<Taps> &r) { full.trace(w, mesh, r); });
+    run("specular", [&](Wave &w, std::vector<Taps> &r) { specular.trace(w, mesh, r); });
+    run("single bounce", [&](Wave &w, std::vector<Taps> &r) { single.trace(w, mesh, r); });
+
+    double error = 0;
+    for (uint64_t r = 0; r < rxs.size(); r++) error = std::max(error, (a[r].field() - b[r].field()).real().norm());
+    std::cout << "generic vs policy<2>: " << error << "\n";
+
+    Nrcc<double, nrcc::Collect> collect;
+    auto start = std::chrono::high_resolution_clock::now();
+    uint64_t collected = 0;
+    for (Wave &wave: tx.transmit(1, 0, 2, 6)) collected += collect.trace(wave, mesh).size();
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "collect: " << duration_cast<std::chrono::microseconds>(stop - start).count() << " us, " << collected
+              << " waves\n";
+
+    return 0;
+}
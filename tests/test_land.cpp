@@ -0,0 +1,126 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to check the terrain heightfield on rolling hills of growing size with a few buildings on them. Each
+// terrain is traced as a heightfield and again triangulated into a plain mesh, and the receivers compared. Per terrain
+// the memory, build and trace times of both are reported; the heightfield should take a fraction of the memory. As the
+// trace times include reception, closest hit queries alone are also timed on both, over downward rays from the
+// transmitter, and their distances compared. A grid whose heights do not match its size must be rejected.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Land.hpp"
+#include "../src/Nrcc.hpp"
+
+int main() {
+    using Vec3 = Vec3<double>;
+    using Face = Face<double>;
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+
+    double frequency = 2.4e9;
+
+    // Two concrete boxes between the transmitter and the receivers.
+    std::vector<Face> buildings;
+    for (double x: {-60.0, 40.0}) {
+        Vec3 l = {x, 0, -20};
+        Vec3 u = {x + 20, 25, 20};
+        std::array<Vec3, 8> p = {Vec3{l.x, l.y, l.z}, Vec3{u.x, l.y, l.z}, Vec3{u.x, l.y, u.z}, Vec3{l.x, l.y, u.z},
+                                 Vec3{l.x, u.y, l.z}, Vec3{u.x, u.y, l.z}, Vec3{u.x, u.y, u.z}, Vec3{l.x, u.y, u.z}};
+        for (const auto &q: std::vector<std::array<int, 4>>{{0, 1, 5, 4}, {1, 2, 6, 5}, {2, 3, 7, 6}, {3, 0, 4, 7},
+                                                            {4, 5, 6, 7}}) {
+            buildings.push_back({p[q[0]], p[q[1]], p[q[2]], nrcc::concrete});
+            buildings.push_back({p[q[0]], p[q[2]], p[q[3]], nrcc::concrete});
+        }
+    }
+
+    Pole tx = {{-200, 40, 10}, {0, 1, 0}, frequency, 1};
+    std::vector<Taps> rxs;
+    for (int i = 0; i < 10; i++) rxs.push_back({{{100.0 + i * 20, 12, -5}, {0, 1, 0}, frequency, 4}, 1e-9, 2000});
+
+    Nrcc<double> rt;
+    for (uint64_t n = 64; n <= 1024; n *= 4) {
+        double spacing = 2000.0 / (n - 1);
+        std::vector<double> heights;
+        for (uint64_t r = 0; r < n; r++) {
+            for (uint64_t c = 0; c < n; c++) {
+                double x = -1000 + c * spacing;
+                double z = -1000 + r * spacing;
+                heights.push_back(3 * std::sin(x / 37) * std::cos(z / 53) + 2 * std::sin((x + z) / 90) - 6);
+            }
+        }
+        std::vector<nrcc::Materials> materials;
+        for (uint64_t cell = 0; cell < (n - 1) * (n - 1); cell++) {
+            materials.push_back(cell % 7 == 0 ? nrcc::swamp : cell % 5 == 0 ? nrcc::desert : nrcc::ground);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        Land<double> land{-1000, -1000, spacing, n, n, heights, materials};
+        land.mesh.add(buildings);
+        auto stop = std::chrono::high_resolution_clock::now();
+        auto land_build = duration_cast<std::chrono::microseconds>(stop - start).count();
+
+        start = std::chrono::high_resolution_clock::now();
+        std::vector<Face> triangles = land.triangulate();
+        Mesh<double> mesh{triangles};
+        mesh.add(buildings);
+        stop = std::chrono::high_resolution_clock::now();
+        auto mesh_build = duration_cast<std::chrono::microseconds>(stop - start).count();
+        uint64_t mesh_bytes = triangles.size() * sizeof(Face) + mesh.groups[0].tree.nodes.size() * sizeof(
+                typename Tree<double>::Node) + mesh.groups[0].tree.indices.size() * sizeof(uint64_t);
+
+        std::vector<Taps> heightfield = rxs;
+        start = std::chrono::high_resolution_clock::now();
+        for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, land, heightfield, 3);
+        stop = std::chrono::high_resolution_clock::now();
+        auto land_trace = duration_cast<std::chrono::microseconds>(stop - start).count();
+
+        std::vector<Taps> plain = rxs;
+        start = std::chrono::high_resolution_clock::now();
+        for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, mesh, plain, 3);
+        stop = std::chrono::high_resolution_clock::now();
+        auto mesh_trace = duration_cast<std::chrono::microseconds>(stop - start).count();
+
+        double error = 0;
+        double scale = 0;
+        for (uint64_t r = 0; r < rxs.size(); r++) {
+            Vec3 e = plain[r].field().real();
+            error = std::max(error, (heightfield[r].field().real() - e).norm());
+            scale = std::max(scale, e.norm());
+        }
+
+        std::cout << n << " x " << n << " samples: heightfield " << land.bytes() << " bytes, build " << land_build
+                  << " us, trace " << land_trace << " us; triangles " << mesh_bytes << " bytes, build " << mesh_build
+                  << " us, trace " << mesh_trace << " us; difference " << error << " of " << scale << "\n";
+
+        std::vector<Vec3> downward;
+        for (const auto &d: nrcc::icosphere<double>(7)) {
+            if (d.y < 0) downward.push_back(d);
+        }
+
+        std::vector<double> land_hits;
+        start = std::chrono::high_resolution_clock::now();
+        for (const auto &d: downward) land_hits.push_back(land.intersect(tx.coordinates, d).distance);
+        stop = std::chrono::high_resolution_clock::now();
+        auto land_query = duration_cast<std::chrono::microseconds>(stop - start).count();
+
+        std::vector<double> mesh_hits;
+        start = std::chrono::high_resolution_clock::now();
+        for (const auto &d: downward) mesh_hits.push_back(mesh.intersect(tx.coordinates, d).distance);
+        stop = std::chrono::high_resolution_clock::now();
+        auto mesh_query = duration_cast<std::chrono::microseconds>(stop - start).count();
+
+        uint64_t mismatches = 0;
+        for (uint64_t i = 0; i < downward.size(); i++) mismatches += std::fabs(land_hits[i] - mesh_hits[i]) > 1e-6;
+        std::cout << n << " x " << n << " samples: " << downward.size() << " closest hits, heightfield " << land_query
+                  << " us, triangles " << mesh_query << " us, " << mismatches << " mismatches\n";
+    }
+
+    Land<double> malformed{0, 0, 1, 4, 4, std::vector<double>(15, 0), std::vector<nrcc::Materials>(9, nrcc::ground)};
+    std::cout << "malformed grid, levels: " << malformed.levels.size() << "\n";
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to check the level of detail hierarchy. Face counts and errors are reported per level, then a low band
+// and a high band run are each traced on the full mesh and on the levels picked per wave, and the received power
+// compared. Receivers stand on a street grid and are split into those in sight of the transmitter and those out of
+// sight, which only reflections reach, since it is the reflecting geometry that the levels simplify. Hit tests alone
+// are also timed without receivers, as they are the only part of a trace that the levels can shorten.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Lods.hpp"
+#include "../src/Nrcc.hpp"
+
+int main() {
+    using Vec3 = Vec3<double>;
+    using Face = Face<double>;
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+
+    std::vector<Face> faces{read<double>((std::ifstream) "../data/magnolia.obj")};
+    faces.push_back({{-200, -40, -200}, {200, -40, 200}, {200, -40, -200}, nrcc::ground});
+    faces.push_back({{-200, -40, -200}, {-200, -40, 200}, {200, -40, 200}, nrcc::ground});
+
+    Lods<double> lods{faces, 0.25, 7};
+    for (uint64_t l = 0; l < lods.levels.size(); l++) {
+        std::cout << "level " << l << ": " << lods.levels[l].size() << " faces, error " << lods.errors[l] << "\n";
+    }
+
+    Nrcc<double> rt;
+    for (double frequency: {1.5e8, 2.4e9}) {
+        std::cout << frequency / 1e9 << " GHz uses level " << lods.level(frequency, 0) << " near the transmitter, "
+                  << lods.level(frequency, 300) << " at 300 m\n";
+
+        Pole tx = {{-150, 30, 120}, {0, 1, 0}, frequency, 1};
+
+        std::vector<Taps> rxs;
+        std::vector<uint8_t> hidden;
+        for (int i = -10; i <= 10; i++) {
+            for (int k = -10; k <= 10; k++) {
+                Vec3 rx = {i * 15.0, -38, k * 15.0};
+                rxs.push_back({{rx, {0, 1, 0}, frequency, 4}, 1e-9, 2000});
+                hidden.push_back(lods.levels[0].occluded(tx.coordinates, rx));
+            }
+        }
+
+        std::vector<Taps> none;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, lods.levels[0], none, 2);
+        auto stop = std::chrono::high_resolution_clock::now();
+        std::cout << "full hits only time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+        start = std::chrono::high_resolution_clock::now();
+        for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, lods, none, 2);
+        stop = std::chrono::high_resolution_clock::now();
+        std::cout << "lods hits only time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+        std::vector<Taps> full = rxs;
+        start = std::chrono::high_resolution_clock::now();
+        for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, lods.levels[0], full, 2);
+        stop = std::chrono::high_resolution_clock::now();
+        std::cout << "full time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+        std::vector<Taps> reduced = rxs;
+        start = std::chrono::high_resolution_clock::now();
+        for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, lods, reduced, 2);
+        stop = std::chrono::high_resolution_clock::now();
+        std::cout << "lods time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+        // Per group: receivers, reached by the full mesh only, by the levels only, by both, and over those reached by
+        // both the mean and largest difference in received power.
+        for (uint8_t h = 0; h < 2; h++) {
+            uint64_t count = 0;
+            uint64_t only_full = 0;
+            uint64_t only_lods = 0;
+            uint64_t both = 0;
+            double mean = 0;
+            double worst = 0;
+            for (uint64_t r = 0; r < rxs.size(); r++) {
+                if (hidden[r] != h) continue;
+                count++;
+
+                double a = 0;
+                double b = 0;
+                for (const auto &p: full[r].pdp()) a += p;
+                for (const auto &p: reduced[r].pdp()) b += p;
+                if (a > 0 && b == 0) only_full++;
+                if (a == 0 && b > 0) only_lods++;
+                if (a == 0 || b == 0) continue;
+
+                double difference = std::fabs(10 * std::log10(b / a));
+                both++;
+                mean += difference;
+                worst = std::max(worst, difference);
+            }
+
+            std::cout << (h ? "out of sight: " : "in sight: ") << count << " receivers, " << both << " reached by both, "
+                      << only_full << " by full only, " << only_lods << " by lods only, full vs lods "
+                      << (both ? mean / both : 0) << " dB mean, " << worst << " dB largest\n";
+        }
+    }
+
+    return 0;
+}
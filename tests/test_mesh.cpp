@@ -0,0 +1,69 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to time a scene with moving geometry. A box "vehicle" drives past a static mesh, and each time step
+// either refits the dynamic group or rebuilds the whole scene before tracing.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Nrcc.hpp"
+#include "../src/Pole.hpp"
+
+int main() {
+    using Vec3 = Vec3<double>;
+    using Face = Face<double>;
+    using Wave = Wave<double>;
+    using Mesh = Mesh<double>;
+
+    std::vector<Face> statics{read<double>((std::ifstream) "../data/magnolia.obj")};
+
+    // Unit box scaled into a 4 x 2 x 1.5 vehicle.
+    std::vector<Vec3> corners;
+    for (int i = 0; i < 8; i++) corners.push_back({(i & 1) * 4.0, (i >> 1 & 1) * 2.0 - 50, (i >> 2 & 1) * 1.5});
+    std::vector<std::array<int, 3>> sides = {{0, 1, 3}, {0, 3, 2}, {4, 6, 7}, {4, 7, 5}, {0, 4, 5}, {0, 5, 1},
+                                             {2, 3, 7}, {2, 7, 6}, {0, 2, 6}, {0, 6, 4}, {1, 5, 7}, {1, 7, 3}};
+    std::vector<Face> vehicle;
+    for (const auto &side: sides) vehicle.push_back({corners[side[0]], corners[side[1]], corners[side[2]]});
+
+    Pole<double> pole = {{0, -70, 5}, {0, 0, 1}, 2.4e9, 1};
+    std::vector<Wave> waves = pole.transmit(1, 0, 2, 4);
+
+    Nrcc<double> rt;
+
+    int steps = 20;
+    Vec3 velocity = {0.5, 0, 0};
+
+    // REFIT
+    auto start = std::chrono::high_resolution_clock::now();
+    Mesh mesh;
+    mesh.add(statics);
+    uint64_t car = mesh.add(vehicle, true);
+    uint64_t refit_count = 0;
+    for (int step = 0; step < steps; step++) {
+        mesh.translate(car, velocity);
+        mesh.refit();
+        for (Wave &wave: waves) refit_count += rt.trace(wave, mesh, 2).size();
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "refit time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+    // REBUILD
+    start = std::chrono::high_resolution_clock::now();
+    uint64_t rebuild_count = 0;
+    for (int step = 0; step < steps; step++) {
+        for (auto &face: vehicle) face = {face.points[0] + velocity, face.points[1] + velocity,
+                                          face.points[2] + velocity};
+        std::vector<Face> faces{read<double>((std::ifstream) "../data/magnolia.obj")};
+        faces.insert(faces.end(), vehicle.begin(), vehicle.end());
+        Mesh rebuilt{faces};
+        for (Wave &wave: waves) rebuild_count += rt.trace(wave, rebuilt, 2).size();
+    }
+    stop = std::chrono::high_resolution_clock::now();
+    std::cout << "rebuild time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+    std::cout << "waves: " << refit_count << ", " << rebuild_count << "\n";
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to check the compact path store. Paths to a row of receivers are written to a pack, read back in a
+// random order and compared against the traced geometry. Reads past the end and packs with too many bits per
+// direction component must be refused, as must corrupt packs: a record through a face the mesh does not have, a record
+// pointing past the endpoint table, and a file cut short.
+
+#include <fstream>
+#include <random>
+#include <filesystem>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Path.hpp"
+#include "../src/Pack.hpp"
+
+int main() {
+    using Vec3 = Vec3<double>;
+    using Mesh = Mesh<double>;
+    using Path = Path<double>;
+    using Track = Track<double>;
+    using Pack = Pack<double>;
+
+    Mesh mesh{read<double>((std::ifstream) "../data/magnolia.obj")};
+    mesh.add({{{-200, -40, -200}, {200, -40, 200}, {200, -40, -200}, nrcc::ground},
+              {{-200, -40, -200}, {-200, -40, 200}, {200, -40, 200}, nrcc::ground}});
+
+    std::vector<Vec3> directions = nrcc::icosphere<double>(5);
+    Vec3 tx = {-150, 30, 120};
+
+    std::vector<Path> paths;
+    Track track{mesh, directions, 2.4e9, 8, 2};
+    for (int i = 0; i < 20; i++) {
+        track.start(tx, {150, 20, 100 + i * 5.0});
+        paths.insert(paths.end(), track.paths.begin(), track.paths.end());
+    }
+
+    uint64_t segments = 0;
+    for (const auto &path: paths) segments += path.points.size() - 1;
+
+    Pack::write("../data/paths.pack", paths);
+    std::ifstream file("../data/paths.pack", std::ifstream::binary | std::ifstream::ate);
+    std::cout << "paths: " << paths.size() << ", segments: " << segments << "\n";
+    std::cout << "pack bytes: " << file.tellg() << ", wave bytes: " << segments * sizeof(Wave<double>) << "\n";
+
+    Pack pack{"../data/paths.pack", mesh};
+
+    std::vector<uint64_t> order(paths.size());
+    for (uint64_t i = 0; i < order.size(); i++) order[i] = i;
+    std::shuffle(order.begin(), order.end(), std::mt19937(1));
+
+    uint64_t mismatches = 0;
+    double max_error = 0;
+    double max_length_error = 0;
+    for (const auto &i: order) {
+        Path path = pack.read(i);
+        if (path.launch != paths[i].launch || path.sequence() != paths[i].sequence()) {
+            mismatches++;
+            continue;
+        }
+        for (uint64_t j = 0; j < path.points.size(); j++) {
+            max_error = std::max(max_error, range(path.points[j], paths[i].points[j]));
+        }
+        max_length_error = std::max(max_length_error, std::fabs(path.length() - paths[i].length()));
+    }
+
+    std::vector<Path> tail = pack.read(pack.size() - 5, 10);
+    std::cout << "sequence mismatches: " << mismatches << ", tail read: " << tail.size() << "\n";
+    std::cout << "max point error: " << max_error << ", max length error: " << max_length_error << "\n";
+
+    Path past = pack.read(pack.size());
+    bool refused = !Pack::write("../data/wide.pack", paths, 17);
+    std::cout << "read past the end: " << past.points.size() << " points, 17 bits refused: " << refused << "\n";
+
+    auto bounced = [](const Path &p) { return !p.faces.empty(); };
+    std::vector<Path> foreign = {*std::find_if(paths.begin(), paths.end(), bounced)};
+    foreign[0].faces[0] = mesh.size();
+    Pack::write("../data/corrupt.pack", foreign);
+    uint64_t past_mesh = Pack{"../data/corrupt.pack", mesh}.read(0).points.size();
+
+    // The first record starts at the first offset of the table. Its transmitter index follows the launch varint.
+    std::ifstream original("../data/paths.pack", std::ifstream::binary);
+    std::string bytes((std::istreambuf_iterator<char>(original)), std::istreambuf_iterator<char>());
+    uint64_t table_position;
+    uint64_t first;
+    std::copy(bytes.end() - 8, bytes.end(), reinterpret_cast<char *>(&table_position));
+    std::copy(bytes.begin() + table_position, bytes.begin() + table_position + 8, reinterpret_cast<char *>(&first));
+    while (bytes[first] & 0x80) first++;
+    bytes[first + 1] = 0x7F;
+    std::ofstream("../data/corrupt.pack", std::ofstream::binary) << bytes;
+    uint64_t past_table = Pack{"../data/corrupt.pack", mesh}.read(0).points.size();
+
+    bytes.resize(bytes.size() / 2);
+    std::ofstream("../data/corrupt.pack", std::ofstream::binary) << bytes;
+    uint64_t truncated = Pack{"../data/corrupt.pack", mesh}.size();
+    std::filesystem::remove("../data/corrupt.pack");
+
+    std::cout << "face past the mesh: " << past_mesh << " points, endpoint past the table: " << past_table
+              << " points, truncated pack: " << truncated << " paths\n";
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to check pulse response synthesis. A lone path should peak at its gain and delay for every pulse shape,
+// and a few random paths should match a direct evaluation of the inverse transform. Magnolia is then traced into ten
+// receivers whose pulse responses are summarized, and thousands of synthetic receivers are synthesized and timed.
+// Finally pulses with a sample count that is not a power of two, too few samples or no bandwidth must be rejected.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Nrcc.hpp"
+#include "../src/Puls.hpp"
+
+int main() {
+    using cmpx = std::complex<double>;
+    using VecC = Vec3<cmpx>;
+    using Puls = Puls<double>;
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+
+    double frequency = 2.4e9;
+    Rand generator{5};
+
+    for (auto shape: {Puls::gaussian, Puls::raised, Puls::flat}) {
+        Puls puls{1024, 1e9, 200e6, shape};
+        VecC gain = {cmpx(0, 0), cmpx(3e-4, -4e-4), cmpx(0, 0)};
+        puls.synthesize({{{100e-9, gain}}});
+
+        std::vector<double> power = puls.envelope(0);
+        uint64_t peak = std::max_element(power.begin(), power.end()) - power.begin();
+        std::cout << "shape " << shape << ": peak at " << puls.time(peak) * 1e9 << " ns, amplitude "
+                  << std::sqrt(power[peak]) << " of 5e-4\n";
+    }
+
+    Puls puls{256, 1e9, 300e6, Puls::raised};
+    std::vector<Puls::Path> paths;
+    for (int i = 0; i < 20; i++) {
+        double phase = 2 * nrcc::pi * generator.uniform();
+        paths.push_back({generator.uniform() * 200e-9, {cmpx(0), std::polar(generator.uniform(), phase), cmpx(0)}});
+    }
+    puls.synthesize({paths});
+
+    double norm = 0;
+    for (uint64_t k = 0; k < puls.samples; k++) norm += puls.spectrum(puls.frequency(k));
+    double error = 0;
+    for (uint64_t n = 0; n < puls.samples; n++) {
+        cmpx direct = 0;
+        for (uint64_t k = 0; k < puls.samples; k++) {
+            double f = puls.frequency(k);
+            cmpx h = 0;
+            for (const auto &path: paths) h += path.gain.y * std::polar(1.0, -2 * nrcc::pi * f * path.delay);
+            direct += h * puls.spectrum(f) / norm * std::polar(1.0, 2 * nrcc::pi * f * puls.time(n));
+        }
+        error = std::max(error, std::abs(direct - puls.responses[0][n].y));
+    }
+    std::cout << "fft against direct: " << error << "\n";
+
+    Mesh<double> mesh{read<double>((std::ifstream) "../data/magnolia.obj")};
+    mesh.add({{{-200, -40, -200}, {200, -40, 200}, {200, -40, -200}, nrcc::ground},
+              {{-200, -40, -200}, {-200, -40, 200}, {200, -40, 200}, nrcc::ground}});
+
+    Pole tx = {{-150, 30, 120}, {0, 1, 0}, frequency, 1};
+    std::vector<Taps> rxs;
+    for (int i = 0; i < 10; i++) rxs.push_back({{{150, 20, -100.0 + i * 20}, {0, 1, 0}, frequency, 4}, 1e-9, 2000});
+
+    Nrcc<double> rt;
+    for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, mesh, rxs, 3);
+
+    Puls pulse{2048, 1e9, 100e6};
+    pulse.synthesize(rxs);
+    for (uint64_t r = 0; r < rxs.size(); r++) {
+        std::vector<double> power = pulse.envelope(r);
+        double p = 0;
+        double t = 0;
+        double t2 = 0;
+        for (uint64_t n = 0; n < pulse.samples; n++) {
+            p += power[n];
+            t += power[n] * pulse.time(n);
+            t2 += power[n] * pulse.time(n) * pulse.time(n);
+        }
+        if (p == 0) continue;
+        std::cout << "receiver " << r << ": channel spread " << rxs[r].delaySpread() * 1e9 << " ns, pulse spread "
+                  << std::sqrt(t2 / p - t / p * t / p) * 1e9 << " ns\n";
+    }
+
+    std::vector<std::vector<Puls::Path>> many(4000);
+    for (auto &receiver: many) {
+        for (int i = 0; i < 100; i++) {
+            double phase = 2 * nrcc::pi * generator.uniform();
+            cmpx gain = std::polar(generator.uniform(), phase);
+            receiver.push_back({generator.uniform() * 1e-6, {cmpx(0), gain, cmpx(0)}});
+        }
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    pulse.synthesize(many);
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << many.size() << " receivers of 100 paths, " << pulse.samples << " samples, " << pulse.threads
+              << " threads: " << duration_cast<std::chrono::milliseconds>(stop - start).count() << " ms\n";
+
+    for (auto [samples, bandwidth]: {std::pair<uint64_t, double>{1000, 200e6}, {4, 200e6}, {1024, 0}, {1024, -1}}) {
+        Puls rejected{samples, 1e9, bandwidth};
+        rejected.synthesize({{{100e-9, {cmpx(0), cmpx(1), cmpx(0)}}}});
+        std::cout << samples << " samples, bandwidth " << bandwidth << ": " << rejected.samples << " samples, "
+                  << rejected.responses[0].size() << " steps\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to check the fields of reflected and refracted waves against closed form Fresnel values. A wave in free
+// space meets a lossless dielectric face at angles from 5 to 85 degrees. The coefficients are compared against
+// Fresnel's sine and tangent forms, rs = -sin(i - t) / sin(i + t), rp = tan(i - t) / tan(i + t),
+// ts = 2 sin t cos i / sin(i + t) and tp = ts / cos(i - t). The child fields for s, p and circular polarization are
+// compared against the incident field split along s and s x k and scaled by those values, and must conserve power.
+// At normal incidence, where the plane of incidence is undefined, every polarization must simply scale by
+// (n1 - n2) / (n1 + n2) and 2 n1 / (n1 + n2). At Brewster's angle p polarization must not reflect.
+
+#include <fstream>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Nrcc.hpp"
+
+int main() {
+    using cmpx = std::complex<double>;
+    using VecC = Vec3<cmpx>;
+    using Vec3 = Vec3<double>;
+    using Face = Face<double>;
+    using Wave = Wave<double>;
+    using Fres = Fres<double>;
+
+    // Lossless glass, and tables fine enough that every lookup is exact.
+    nrcc::conductivity[nrcc::glass] = {0, 0};
+    Fres::tolerance = 1e-12;
+
+    double frequency = 2.4e9;
+    double n1 = 1;
+    double n2 = nrcc::refractiveIndex(nrcc::glass, frequency).real();
+
+    // Face in the plane y = 0 with its normal along +y, towards the sources.
+    Face face = {{-100, 0, -100}, {-100, 0, 100}, {100, 0, -100}, nrcc::glass};
+    Vec3 n = face.normal();
+    Vec3 aim = {-50, 0, -50};
+
+    Nrcc<double> rt;
+
+    auto magnitude = [](const VecC &v) { return std::sqrt(std::norm(v.x) + std::norm(v.y) + std::norm(v.z)); };
+
+    // Reflected and refracted fields leaving the face for a wave from angle i in the x y plane.
+    auto interact = [&](const double &i, const VecC &polar, VecC &ei, VecC &er, VecC &et, Vec3 &kr, Vec3 &kt) {
+        Vec3 source = aim + Vec3{std::sin(i), std::cos(i), 0} * 10;
+        Wave incident = {source, (aim - source).unit(), frequency, 1, 0, polar};
+        Wave reflected = rt.reflectedWave(incident, face);
+        Wave refracted = rt.refractedWave(incident, face);
+
+        ei = incident.electricField(range(source, aim));
+        er = reflected.electricField(0);
+        et = refracted.electricField(0);
+        kr = reflected.direct.unit();
+        kt = refracted.direct.unit();
+    };
+
+    // COEFFICIENTS
+    double worst_coefficient = 0;
+    for (int degrees = 5; degrees <= 85; degrees++) {
+        double i = degrees * nrcc::pi / 180;
+        double t = std::asin(n1 * std::sin(i) / n2);
+
+        std::array<double, 4> closed = {-std::sin(i - t) / std::sin(i + t), std::tan(i - t) / std::tan(i + t),
+                                        2 * std::sin(t) * std::cos(i) / std::sin(i + t),
+                                        2 * std::sin(t) * std::cos(i) / (std::sin(i + t) * std::cos(i - t))};
+        Fres::Coefficients c = Fres::exact(n1, n2, std::cos(i));
+        for (int k = 0; k < 4; k++) worst_coefficient = std::max(worst_coefficient, std::abs(c[k] - closed[k]));
+    }
+    std::cout << "n2 " << n2 << ", coefficients, largest difference from closed form: " << worst_coefficient << "\n";
+
+    // FIELDS
+    double worst_field = 0;
+    double worst_power = 0;
+    for (int degrees = 5; degrees <= 85; degrees++) {
+        double i = degrees * nrcc::pi / 180;
+        double t = std::asin(n1 * std::sin(i) / n2);
+        double rs = -std::sin(i - t) / std::sin(i + t);
+        double rp = std::tan(i - t) / std::tan(i + t);
+        double ts = 2 * std::sin(t) * std::cos(i) / std::sin(i + t);
+        double tp = ts / std::cos(i - t);
+
+        Vec3 ki = (aim - (aim + Vec3{std::sin(i), std::cos(i), 0})).unit();
+        Vec3 s = cross(ki, n).unit();
+        Vec3 p = cross(s, ki);
+
+        for (const VecC &polar: {s.cmpx(), p.cmpx(), s.cmpx() + p.cmpx() * nrcc::j}) {
+            VecC ei, er, et;
+            Vec3 kr, kt;
+            interact(i, polar, ei, er, et, kr, kt);
+
+            cmpx es = dot(ei, s);
+            cmpx ep = dot(ei, p);
+            VecC expected_r = s.cmpx() * (es * rs) + cross(s, kr).cmpx() * (ep * rp);
+            VecC expected_t = s.cmpx() * (es * ts) + cross(s, kt).cmpx() * (ep * tp);
+
+            double scale = magnitude(ei);
+            worst_field = std::max({worst_field, magnitude(er - expected_r) / scale, magnitude(et - expected_t) / scale});
+
+            // Power through the face: reflected plus transmitted intensity over the incident one, per unit face area.
+            double transmittance = n2 * std::cos(t) / (n1 * std::cos(i));
+            double balance = (std::pow(magnitude(er), 2) + transmittance * std::pow(magnitude(et), 2)) / (scale * scale);
+            worst_power = std::max(worst_power, std::fabs(balance - 1));
+        }
+    }
+    std::cout << "fields, largest relative difference from closed form: " << worst_field
+              << ", largest power imbalance: " << worst_power << "\n";
+
+    // NORMAL INCIDENCE
+    double r0 = (n1 - n2) / (n1 + n2);
+    double t0 = 2 * n1 / (n1 + n2);
+    double worst_normal = 0;
+    for (const Vec3 &polar: {Vec3{1, 0, 0}, Vec3{0, 0, 1}, Vec3{1, 0, 1}}) {
+        VecC ei, er, et;
+        Vec3 kr, kt;
+        interact(0, polar.cmpx(), ei, er, et, kr, kt);
+
+        double scale = magnitude(ei);
+        worst_normal = std::max({worst_normal, magnitude(er - ei * cmpx(r0)) / scale,
+                                 magnitude(et - ei * cmpx(t0)) / scale});
+    }
+    std::cout << "normal incidence, largest relative difference from (n1 - n2) / (n1 + n2) and 2 n1 / (n1 + n2): "
+              << worst_normal << "\n";
+
+    // BREWSTER
+    double brewster = std::atan(n2 / n1);
+    Vec3 ki = Vec3{-std::sin(brewster), -std::cos(brewster), 0};
+    Vec3 p = cross(cross(ki, n).unit(), ki);
+    VecC ei, er, et;
+    Vec3 kr, kt;
+    interact(brewster, p.cmpx(), ei, er, et, kr, kt);
+    std::cout << "brewster angle " << brewster * 180 / nrcc::pi << " degrees, p reflected over incident: "
+              << magnitude(er) / magnitude(ei) << "\n";
+
+    return 0;
+}
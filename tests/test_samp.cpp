@@ -0,0 +1,48 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to compare launch samplers. Each integrates the power pattern of a vertical dipole, whose mean over the
+// sphere is 2 / 3, at a range of ray counts. Random directions are included as the baseline.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Util.hpp"
+#include "../src/Pole.hpp"
+
+int main() {
+    using Vec3 = Vec3<double>;
+
+    auto error = [](const std::vector<Vec3> &directions) {
+        double sum = 0;
+        for (const auto &d: directions) sum += 1 - d.z * d.z;
+        return std::fabs(sum / directions.size() - 2.0 / 3);
+    };
+
+    std::ofstream errors("../data/samp_errors.txt", std::ofstream::out);
+    for (uint64_t count: {100, 300, 1000, 3000, 10000, 30000}) {
+        Rand generator{1, count};
+        std::vector<Vec3> random;
+        for (uint64_t i = 0; i < count; i++) random.push_back(randomVector<double>(generator));
+
+        errors << count << ", " << error(random) << ", " << error(nrcc::stratified<double>(count, generator)) << ", "
+               << error(nrcc::sobol<double>(count)) << ", " << error(nrcc::fibonacci<double>(count)) << "\n";
+    }
+    errors.close();
+
+    auto start = std::chrono::high_resolution_clock::now();
+    Vec3 previous = randomVector<double>();
+    uint64_t repeats = 0;
+    for (int i = 0; i < 1000000; i++) {
+        Vec3 v = randomVector<double>();
+        if (v.x == previous.x && v.y == previous.y && v.z == previous.z) repeats++;
+        previous = v;
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "random vectors: " << duration_cast<std::chrono::microseconds>(stop - start).count()
+              << " us per million, repeats: " << repeats << "\n";
+
+    Pole pole{{0, 0, 0}, {0, 0, 1}, 2.4e9, 0.1};
+    std::cout << "waves launched: " << pole.transmit(1, 0, 2, nrcc::fibonacci<double>(1234)).size() << "\n";
+
+    return 0;
+}
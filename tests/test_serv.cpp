@@ -0,0 +1,164 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to compare server queries against cold runs that load the scene for every query, as a process per
+// query would. The server is driven over a socket pair from this process; results must match the cold runs. Loads
+// outside the server's root, queries over its maxima and a request claiming a body over its limit must be refused
+// rather than allocated.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Serv.hpp"
+
+int main() {
+    using Vec3 = Vec3<double>;
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+    using Serv = Serv<double>;
+
+    std::vector<Vec3> txs;
+    for (int i = 0; i < 20; i++) txs.push_back({-150, 30, -95.0 + i * 10});
+
+    std::vector<Vec3> positions;
+    for (int i = 0; i < 10; i++) positions.push_back({150, 20, -100.0 + i * 20});
+
+    // COLD
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::vector<Taps>> cold;
+    for (const auto &tx: txs) {
+        Mesh<double> mesh{read<double>((std::ifstream) "../data/magnolia.obj")};
+        std::vector<Taps> rxs;
+        for (const auto &p: positions) rxs.push_back({{p, {0, 1, 0}, 2.4e9, 4}, 1e-9, 500});
+
+        Pole pole = {tx, {0, 1, 0}, 2.4e9, 1};
+        Nrcc<double> rt;
+        for (Wave &wave: pole.transmit(1, 0, 2, 4)) rt.trace(wave, mesh, rxs, 2);
+        cold.push_back(rxs);
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "cold per query: " << duration_cast<std::chrono::microseconds>(stop - start).count() / txs.size()
+              << " us\n";
+
+    // SERVER
+    int fds[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+
+    Serv server;
+    server.root = "../data";
+    std::thread serving([&] {
+        server.serve(fds[1], fds[1]);
+        close(fds[1]);
+    });
+
+    auto request = [&](const uint32_t &op, const uint64_t &id, const std::string &body) {
+        Serv::Header header = {Serv::magic, op, id, body.size()};
+        write(fds[0], &header, sizeof(header));
+        write(fds[0], body.data(), body.size());
+    };
+    auto response = [&](Serv::Header &header) {
+        read(fds[0], &header, sizeof(header));
+        std::string body(header.length, '\0');
+        for (uint64_t got = 0; got < body.size();) got += read(fds[0], body.data() + got, body.size() - got);
+        return body;
+    };
+
+    std::ostringstream body;
+    auto put = [&](const auto &value) { body.write(reinterpret_cast<const char *>(&value), sizeof(value)); };
+    auto text = [&](const std::string &s) {
+        put(static_cast<uint64_t>(s.size()));
+        body.write(s.data(), s.size());
+    };
+    auto vec = [&](const Vec3 &v) {
+        put(v.x);
+        put(v.y);
+        put(v.z);
+    };
+
+    start = std::chrono::high_resolution_clock::now();
+    text("magnolia");
+    text("magnolia.obj");
+    request(Serv::load, 0, body.str());
+    Serv::Header header;
+    response(header);
+    stop = std::chrono::high_resolution_clock::now();
+    std::cout << "load status: " << header.op << ", "
+              << duration_cast<std::chrono::microseconds>(stop - start).count() << " us\n";
+
+    for (const std::string &outside: {"../src/Serv.hpp", "/etc/hostname", "../data/../src/Mesh.hpp"}) {
+        body.str("");
+        text("outside");
+        text(outside);
+        request(Serv::load, 0, body.str());
+        response(header);
+        std::cout << "load " << outside << " status: " << header.op << "\n";
+    }
+
+    auto query = [&](const Vec3 &tx, const uint64_t &accuracy, const uint8_t &depth, const uint64_t &bins,
+                     const uint64_t &count) {
+        body.str("");
+        text("magnolia");
+        vec(tx);
+        vec({0, 1, 0});
+        put(2.4e9);
+        put(1.0);
+        put(accuracy);
+        put(depth);
+        put(1e-9);
+        put(bins);
+        put(count);
+        for (uint64_t r = 0; r < std::min<uint64_t>(count, positions.size()); r++) {
+            vec(positions[r]);
+            put(4.0);
+        }
+        return body.str();
+    };
+
+    std::vector<std::array<uint64_t, 4>> excessive = {{server.max_accuracy + 1, 2, 500, positions.size()},
+                                                       {4, server.max_depth + 1ul, 500, positions.size()},
+                                                       {4, 2, server.max_bins + 1, 1},
+                                                       {4, 2, 500, server.max_receivers + 1},
+                                                       {4, 2, 1ul << 62, 1ul << 10}};
+    for (const auto &[accuracy, depth, bins, count]: excessive) {
+        request(Serv::query, 0, query(txs[0], accuracy, depth, bins, count));
+        response(header);
+        std::cout << "query accuracy " << accuracy << ", depth " << depth << ", " << bins << " bins, " << count
+                  << " receivers status: " << header.op << "\n";
+    }
+
+    start = std::chrono::high_resolution_clock::now();
+    for (uint64_t q = 0; q < txs.size(); q++) {
+        request(Serv::query, q + 1, query(txs[q], 4, 2, 500, positions.size()));
+    }
+
+    double error = 0;
+    for (uint64_t q = 0; q < txs.size(); q++) {
+        std::istringstream result(response(header));
+        uint64_t n;
+        result.read(reinterpret_cast<char *>(&n), sizeof(n));
+
+        std::vector<Taps> &expected = cold[header.id - 1];
+        for (uint64_t r = 0; r < n; r++) {
+            Taps taps = expected[r];
+            taps.read(result);
+            error = std::max(error, (taps.field() - expected[r].field()).real().norm());
+        }
+    }
+    stop = std::chrono::high_resolution_clock::now();
+    std::cout << "server per query: " << duration_cast<std::chrono::microseconds>(stop - start).count() / txs.size()
+              << " us\n";
+    std::cout << "server vs cold: " << error << "\n";
+
+    Serv::Header oversized = {Serv::magic, Serv::query, 99, server.limit + 1};
+    write(fds[0], &oversized, sizeof(oversized));
+    response(header);
+    std::cout << "oversized request status: " << header.op << ", id " << header.id << "\n";
+
+    shutdown(fds[0], SHUT_WR);
+    serving.join();
+    close(fds[0]);
+
+    return 0;
+}
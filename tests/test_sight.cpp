@@ -0,0 +1,77 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to compare line of sight maps from closest hit intersection against the any hit occlusion queries.
+// A grid of receivers is laid out around the mesh and each is checked against a single transmitter.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Nrcc.hpp"
+
+int main() {
+    using Vec3 = Vec3<double>;
+    using Face = Face<double>;
+
+    std::vector<Face> mesh{read<double>((std::ifstream) "../data/magnolia.obj")};
+
+    Nrcc<double> rt;
+
+    Vec3 tx = {0, -60, 10};
+
+    std::vector<Vec3> rxs;
+    for (int i = -50; i < 50; i++) {
+        for (int k = -50; k < 50; k++) {
+            rxs.push_back({i * 0.8, 40.0, k * 0.8});
+        }
+    }
+
+    // CLOSEST HIT
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<uint8_t> closest;
+    for (const auto &rx: rxs) {
+        Vec3 direct = (rx - tx).unit();
+        double nearest = nrcc::infinity;
+        for (const auto &face: mesh) {
+            double distance = nrcc::intersectionDistance(tx, direct, face);
+            if (distance > nrcc::epsilon && distance < nearest) nearest = distance;
+        }
+        closest.push_back(nearest < range(tx, rx) - nrcc::epsilon);
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "closest hit time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+    // ANY HIT
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<uint8_t> any;
+    for (const auto &rx: rxs) {
+        any.push_back(rt.occluded(tx, rx, mesh));
+    }
+    stop = std::chrono::high_resolution_clock::now();
+    std::cout << "any hit time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+    // ANY HIT WITH TREE, BATCHED
+    start = std::chrono::high_resolution_clock::now();
+    Tree<double> tree = ::tree(mesh);
+    std::vector<std::array<Vec3, 2>> segments;
+    for (const auto &rx: rxs) {
+        segments.push_back({tx, rx});
+    }
+    std::vector<uint8_t> batch = rt.occluded(segments, mesh, tree);
+    stop = std::chrono::high_resolution_clock::now();
+    std::cout << "batched tree time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+    int mismatches = 0;
+    for (uint64_t i = 0; i < rxs.size(); i++) {
+        mismatches += (closest[i] != any[i]) + (closest[i] != batch[i]);
+    }
+    std::cout << "mismatches: " << mismatches << "\n";
+
+    std::ofstream sight("../data/sight.txt", std::ofstream::out);
+    for (uint64_t i = 0; i < rxs.size(); i++) {
+        sight << rxs[i] << ", " << static_cast<int>(batch[i]) << "\n";
+    }
+    sight.close();
+
+    return 0;
+}
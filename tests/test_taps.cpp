@@ -0,0 +1,65 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to build channel impulse responses while tracing. Receivers in a line accumulate binned taps during a
+// streaming trace, and the power delay profile and RMS delay spread of each are written out. A written accumulator
+// must read back only into one with the same bins, sectors, resolution and capacity.
+// Output files can be read by matlab functions in /tools/
+
+#include <fstream>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Nrcc.hpp"
+#include "../src/Pole.hpp"
+#include "../src/Taps.hpp"
+
+int main() {
+    using Wave = Wave<double>;
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+
+    Mesh<double> mesh{read<double>((std::ifstream) "../data/magnolia.obj")};
+    mesh.add({{{-200, -40, -200}, {200, -40, 200}, {200, -40, -200}, nrcc::ground},
+              {{-200, -40, -200}, {-200, -40, 200}, {200, -40, 200}, nrcc::ground}});
+
+    Pole tx = {{-150, 30, 120}, {0, 1, 0}, 2.4e9, 1};
+    std::vector<Wave> waves = tx.transmit(1, 0, 2, 6);
+
+    std::vector<Taps> receivers;
+    for (int i = 0; i < 10; i++) {
+        receivers.push_back({{{150, 20, 100.0 + i * 10}, {0, 1, 0}, 2.4e9, 4}, 1e-9, 2000});
+    }
+
+    Nrcc<double> rt;
+    for (Wave &wave: waves) rt.trace(wave, mesh, receivers, 2);
+
+    std::ofstream pdps("../data/taps_pdp.txt", std::ofstream::out);
+    for (const auto &rx: receivers) {
+        std::cout << rx.pole.coordinates << ": " << rx.count << " waves, " << rx.taps.size() << " taps, "
+                  << rx.meanDelay() * 1e9 << " ns mean, " << rx.delaySpread() * 1e9 << " ns rms\n";
+
+        std::vector<double> pdp = rx.pdp();
+        for (uint64_t i = 0; i < pdp.size(); i++) {
+            pdps << (i == 0 ? "" : ", ") << pdp[i];
+        }
+        pdps << "\n";
+    }
+    pdps.close();
+
+    std::ostringstream written;
+    receivers[0].write(written);
+    const Pole &pole = receivers[0].pole;
+    std::vector<std::pair<std::string, Taps>> readers = {{"same", {pole, 1e-9, 2000}},
+                                                         {"other bins", {pole, 1e-9, 1000}},
+                                                         {"other sectors", {pole, 1e-9, 2000, 4}},
+                                                         {"other resolution", {pole, 2e-9, 2000}},
+                                                         {"other capacity", {pole, 1e-9, 2000, 8, 128}}};
+    for (auto &[name, reader]: readers) {
+        std::istringstream stream(written.str());
+        bool read = reader.read(stream);
+        std::cout << name << " read back: " << read << (read ? ", " + std::to_string(reader.taps.size()) + " taps" : "")
+                  << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to check out of core tracing on generated cities of growing size. Each city is written as tiles and
+// traced under the same memory budget, with tiles read on demand, and the receivers compared against a trace of the
+// whole city in memory. Tile reads and peak resident bytes are reported per city; the peak should stay at the budget
+// however large the city.
+
+#include <fstream>
+#include <chrono>
+#include <filesystem>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Nrcc.hpp"
+#include "../src/Tile.hpp"
+
+// Box building on the ground, with every wall and the roof split into n by n quads.
+void building(std::vector<Face<double>> &faces, const Vec3<double> &lower, const Vec3<double> &upper, const int &n) {
+    using Vec3 = Vec3<double>;
+
+    auto quad = [&](const Vec3 &o, const Vec3 &u, const Vec3 &v) {
+        for (int i = 0; i < n; i++) {
+            for (int k = 0; k < n; k++) {
+                Vec3 p00 = o + u * (i / double(n)) + v * (k / double(n));
+                Vec3 p10 = o + u * ((i + 1) / double(n)) + v * (k / double(n));
+                Vec3 p11 = o + u * ((i + 1) / double(n)) + v * ((k + 1) / double(n));
+                Vec3 p01 = o + u * (i / double(n)) + v * ((k + 1) / double(n));
+                faces.push_back({p00, p10, p11, nrcc::concrete});
+                faces.push_back({p00, p11, p01, nrcc::concrete});
+            }
+        }
+    };
+
+    Vec3 d = upper - lower;
+    quad(lower, {d.x, 0, 0}, {0, d.y, 0});
+    quad(lower, {0, d.y, 0}, {0, 0, d.z});
+    quad({lower.x, lower.y, upper.z}, {0, d.y, 0}, {d.x, 0, 0});
+    quad({upper.x, lower.y, lower.z}, {0, 0, d.z}, {0, d.y, 0});
+    quad({lower.x, upper.y, lower.z}, {0, 0, d.z}, {d.x, 0, 0});
+}
+
+std::vector<Face<double>> city(const int &blocks) {
+    std::vector<Face<double>> faces;
+    double half = blocks * 40 / 2.0;
+
+    for (int i = 0; i < blocks; i++) {
+        for (int k = 0; k < blocks; k++) {
+            double x = -half + i * 40;
+            double z = -half + k * 40;
+            faces.push_back({{x, 0, z}, {x, 0, z + 40}, {x + 40, 0, z + 40}, nrcc::ground});
+            faces.push_back({{x, 0, z}, {x + 40, 0, z + 40}, {x + 40, 0, z}, nrcc::ground});
+            building(faces, {x + 8, 0, z + 8}, {x + 32, 10.0 + (i * 7 + k * 13) % 30, z + 32}, 4);
+        }
+    }
+    return faces;
+}
+
+int main() {
+    using Pole = Pole<double>;
+    using Taps = Taps<double>;
+    using Wave = Wave<double>;
+
+    Pole tx = {{4, 45, 3}, {0, 1, 0}, 2.4e9, 1};
+
+    std::vector<Taps> rxs;
+    for (int i = 0; i < 10; i++) rxs.push_back({{{-90.0 + i * 20, 2, 21}, {0, 1, 0}, 2.4e9, 4}, 1e-9, 2000});
+
+    uint64_t budget = 1 << 20;
+
+    for (int blocks: {8, 16, 32}) {
+        std::vector<Face<double>> faces = city(blocks);
+        std::string directory = "tiles_" + std::to_string(blocks);
+        std::filesystem::create_directories(directory);
+        Tile<double>::write(directory, faces, 80);
+
+        Mesh<double> mesh{faces};
+        std::vector<Taps> full = rxs;
+        Nrcc<double> rt;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (Wave &wave: tx.transmit(1, 0, 2, 5)) rt.trace(wave, mesh, full, 2);
+        auto stop = std::chrono::high_resolution_clock::now();
+        std::cout << blocks << " blocks, " << faces.size() << " faces, in memory time: "
+                  << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+        Tile<double> tiles{directory, budget};
+        std::vector<Taps> tiled = rxs;
+        std::vector<Wave> waves = tx.transmit(1, 0, 2, 5);
+        start = std::chrono::high_resolution_clock::now();
+        tiles.trace(waves, tiled, 2);
+        stop = std::chrono::high_resolution_clock::now();
+        std::cout << blocks << " blocks, " << tiles.size() << " tiles, tiled time: "
+                  << duration_cast<std::chrono::microseconds>(stop - start).count() << ", tile reads: " << tiles.loads
+                  << ", rays per read: " << tiles.visits / tiles.loads
+                  << ", peak resident: " << tiles.peak << " of " << budget << " bytes\n";
+
+        double error = 0;
+        double scale = 0;
+        for (uint64_t r = 0; r < rxs.size(); r++) {
+            error = std::max(error, (full[r].field() - tiled[r].field()).real().norm());
+            scale = std::max(scale, full[r].field().real().norm());
+        }
+        std::cout << blocks << " blocks, tiled vs in memory: " << error << " of " << scale << "\n";
+
+        std::filesystem::remove_all(directory);
+    }
+
+    return 0;
+}
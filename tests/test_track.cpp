@@ -0,0 +1,92 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to compare path reuse along a route against tracing every route point from scratch. A receiver drives
+// past the mesh in small steps while the transmitter stays put. At each point the paths are matched by face and
+// interaction sequence, and the points where the two sets differ or a matched path's length differs are counted.
+
+#include <fstream>
+#include <chrono>
+#include <map>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Mesh.hpp"
+#include "../src/Path.hpp"
+
+int main() {
+    using Vec3 = Vec3<double>;
+    using Mesh = Mesh<double>;
+    using Track = Track<double>;
+    using Path = Path<double>;
+
+    Mesh mesh{read<double>((std::ifstream) "../data/magnolia.obj")};
+    mesh.add({{{-200, -40, -200}, {200, -40, 200}, {200, -40, -200}, nrcc::ground},
+              {{-200, -40, -200}, {-200, -40, 200}, {200, -40, 200}, nrcc::ground}});
+
+    std::vector<Vec3> directions = nrcc::icosphere<double>(5);
+
+    Vec3 tx = {-150, 30, 120};
+
+    std::vector<Vec3> route;
+    for (int i = 0; i < 100; i++) {
+        route.push_back({150, 20, 100 + i * 0.2});
+    }
+
+    // PATH REUSE
+    auto start = std::chrono::high_resolution_clock::now();
+    Track reuse{mesh, directions, 2.4e9, 8, 2};
+    reuse.refresh = 50;
+    reuse.start(tx, route[0]);
+    std::vector<std::vector<Path>> reuse_paths{reuse.paths};
+    uint64_t retraced = 0;
+    for (uint64_t i = 1; i < route.size(); i++) {
+        reuse.step(tx, route[i]);
+        reuse_paths.push_back(reuse.paths);
+        retraced += reuse.retraced;
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << "reuse time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+    std::cout << "launches retraced: " << retraced << " of " << directions.size() * (route.size() - 1) << "\n";
+
+    // FULL RETRACE
+    start = std::chrono::high_resolution_clock::now();
+    Track full{mesh, directions, 2.4e9, 8, 2};
+    std::vector<std::vector<Path>> full_paths;
+    for (const auto &rx: route) {
+        full.start(tx, rx);
+        full_paths.push_back(full.paths);
+    }
+    stop = std::chrono::high_resolution_clock::now();
+    std::cout << "retrace time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+    // COMPARISON
+    uint64_t mismatches = 0;
+    uint64_t matched = 0;
+    double worst = 0;
+    std::ofstream counts("../data/track_counts.txt", std::ofstream::out);
+    for (uint64_t i = 0; i < route.size(); i++) {
+        std::map<std::vector<uint64_t>, double> lengths;
+        for (const auto &path: full_paths[i]) lengths[path.sequence()] = path.length();
+
+        bool same = reuse_paths[i].size() == full_paths[i].size();
+        for (const auto &path: reuse_paths[i]) {
+            auto found = lengths.find(path.sequence());
+            if (found == lengths.end()) {
+                same = false;
+                continue;
+            }
+            double difference = std::fabs(path.length() - found->second);
+            worst = std::max(worst, difference);
+            same = same && difference < 1e-6;
+            matched++;
+        }
+        mismatches += !same;
+
+        counts << route[i] << ", " << reuse_paths[i].size() << ", " << full_paths[i].size() << "\n";
+    }
+    counts.close();
+
+    std::cout << "paths matched: " << matched << ", largest length difference: " << worst << " m\n";
+    std::cout << "route points where reuse and retrace differ: " << mismatches << " of " << route.size() << "\n";
+
+    return 0;
+}
@@ -2,6 +2,9 @@
 
 // Test designed to view EH field changes with time. Adjusting polar will result in varied waveforms.
 // Output files can be read by matlab functions in /tools/
+//
+// The batched fields() are also checked against per sample electricField() and magneticField(), and the largest
+// difference relative to the amplitude is printed for each wave.
 
 #include <fstream>
 #include "../src/Vec3.hpp"
@@ -9,6 +12,7 @@
 #include "../src/Nrcc.hpp"
 
 int main() {
+    using VecC = Vec3<std::complex<double>>;
     using Vec3 = Vec3<double>;
     using Wave = Wave<double>;
 
@@ -36,77 +40,50 @@ int main() {
     std::cout << "t refract: " << refraction.phase(r) << "\n";
     std::cout << "p refract: " << refraction.polar(r) << "\n";
 
-    // make list of distances
-    std::vector<double> distances;
-    for (int i = 0; i < rt.intersectionVector(parent, face).norm() / .001; i++) {
-        distances.push_back(i * 0.001);
+    // sample fields along each wave
+    double step = 0.001;
+    uint64_t count = std::ceil(rt.intersectionVector(parent, face).norm() / step);
+
+    std::vector<Wave *> sampled = {&parent, &reflection, &refraction};
+
+    for (int w = 0; w < sampled.size(); w++) {
+        std::vector<VecC> e_fields(count);
+        std::vector<VecC> m_fields(count);
+        sampled[w]->fields(0, step, count, e_fields.data(), m_fields.data());
+
+        std::vector<VecC> m_only = sampled[w]->magneticFields(0, step, count);
+
+        double worst = 0;
+        for (uint64_t i = 0; i < count; i++) {
+            VecC e = sampled[w]->electricField(i * step);
+            VecC m = sampled[w]->magneticField(i * step);
+            for (int c = 0; c < 3; c++) {
+                worst = std::max(worst, std::abs(e_fields[i].v[c] - e.v[c]));
+                worst = std::max(worst, std::abs(m_fields[i].v[c] - m.v[c]));
+                worst = std::max(worst, std::abs(m_only[i].v[c] - m.v[c]));
+            }
+        }
+        std::cout << "wave " << w << ": " << count << " samples, largest difference from per sample fields "
+                  << worst / sampled[w]->amplitude(0) << "\n";
+
+        std::string name = "../data/wave_" + std::to_string(w);
+
+        std::ofstream wave_e_o(name + "_e_o.txt", std::ofstream::out);
+        std::ofstream wave_e_d(name + "_e_d.txt", std::ofstream::out);
+        std::ofstream wave_m_o(name + "_m_o.txt", std::ofstream::out);
+        std::ofstream wave_m_d(name + "_m_d.txt", std::ofstream::out);
+        for (uint64_t i = 0; i < count; i++) {
+            Vec3 point_i = sampled[w]->direct.unit() * (i * step) + sampled[w]->origin;
+            wave_e_o << point_i << "\n";
+            wave_e_d << e_fields[i].real() * 0.1 << "\n";
+            wave_m_o << point_i << "\n";
+            wave_m_d << m_fields[i].real() * 0.1 << "\n";
+        }
+        wave_e_o.close();
+        wave_e_d.close();
+        wave_m_o.close();
+        wave_m_d.close();
     }
 
-    std::ofstream wave_0_e_o("../data/wave_0_e_o.txt", std::ofstream::out);
-    std::ofstream wave_0_e_d("../data/wave_0_e_d.txt", std::ofstream::out);
-    for (const auto &distance: distances) {
-        Vec3 point_i = parent.direct.unit() * distance + parent.origin;
-        Vec3 field_i = parent.electricField(distance).real() * 0.1;
-        wave_0_e_o << point_i << "\n";
-        wave_0_e_d << field_i << "\n";
-    }
-    wave_0_e_o.close();
-    wave_0_e_d.close();
-
-    std::ofstream wave_0_m_o("../data/wave_0_m_o.txt", std::ofstream::out);
-    std::ofstream wave_0_m_d("../data/wave_0_m_d.txt", std::ofstream::out);
-    for (const auto &distance: distances) {
-        Vec3 point_i = parent.direct.unit() * distance + parent.origin;
-        Vec3 field_i = parent.magneticField(distance).real() * 0.1;
-        wave_0_m_o << point_i << "\n";
-        wave_0_m_d << field_i << "\n";
-    }
-    wave_0_m_o.close();
-    wave_0_m_d.close();
-
-    std::ofstream wave_1_e_o("../data/wave_1_e_o.txt", std::ofstream::out);
-    std::ofstream wave_1_e_d("../data/wave_1_e_d.txt", std::ofstream::out);
-    for (const auto &distance: distances) {
-        Vec3 point_i = reflection.direct.unit() * distance + reflection.origin;
-        Vec3 field_i = reflection.electricField(distance).real() * 0.1;
-        wave_1_e_o << point_i << "\n";
-        wave_1_e_d << field_i << "\n";
-    }
-    wave_1_e_o.close();
-    wave_1_e_d.close();
-
-    std::ofstream wave_1_m_o("../data/wave_1_m_o.txt", std::ofstream::out);
-    std::ofstream wave_1_m_d("../data/wave_1_m_d.txt", std::ofstream::out);
-    for (const auto &distance: distances) {
-        Vec3 point_i = reflection.direct.unit() * distance + reflection.origin;
-        Vec3 field_i = reflection.magneticField(distance).real() * 0.1;
-        wave_1_m_o << point_i << "\n";
-        wave_1_m_d << field_i << "\n";
-    }
-    wave_1_m_o.close();
-    wave_1_m_d.close();
-
-    std::ofstream wave_2_e_o("../data/wave_2_e_o.txt", std::ofstream::out);
-    std::ofstream wave_2_e_d("../data/wave_2_e_d.txt", std::ofstream::out);
-    for (const auto &distance: distances) {
-        Vec3 point_i = refraction.direct.unit() * distance + refraction.origin;
-        Vec3 field_i = refraction.electricField(distance).real() * 0.1;
-        wave_2_e_o << point_i << "\n";
-        wave_2_e_d << field_i << "\n";
-    }
-    wave_2_e_o.close();
-    wave_2_e_d.close();
-
-    std::ofstream wave_2_m_o("../data/wave_2_m_o.txt", std::ofstream::out);
-    std::ofstream wave_2_m_d("../data/wave_2_m_d.txt", std::ofstream::out);
-    for (const auto &distance: distances) {
-        Vec3 point_i = refraction.direct.unit() * distance + refraction.origin;
-        Vec3 field_i = refraction.magneticField(distance).real() * 0.1;
-        wave_2_m_o << point_i << "\n";
-        wave_2_m_d << field_i << "\n";
-    }
-    wave_2_m_o.close();
-    wave_2_m_d.close();
-
     return 0;
 }
\ No newline at end of file
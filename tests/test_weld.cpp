@@ -0,0 +1,137 @@
+// Copyright(c) 2023, Matthew Petrin, All rights reserved.
+
+// Test designed to check load time welding and coplanar merging. Besides magnolia, a block of buildings is generated the
+// way city exports tessellate them, with every wall split into a grid of triangles, some duplicated and some slivers.
+// Face and wedge counts are reported for each stage, and line of sight maps are compared before and after merging. The
+// merged block is then moved back and forth as a dynamic group, which must not add polygons, and copied into a mesh
+// that must keep working once the original and the merge's corner table are gone.
+
+#include <fstream>
+#include <chrono>
+#include "../src/Vec3.hpp"
+#include "../src/Face.hpp"
+#include "../src/Edge.hpp"
+#include "../src/Nrcc.hpp"
+#include "../src/Weld.hpp"
+
+// Grid of n by n quads over the rectangle o + [0, 1] u + [0, 1] v, wound towards u x v.
+void wall(std::vector<Face<double>> &faces, const Vec3<double> &o, const Vec3<double> &u, const Vec3<double> &v,
+          const int &n) {
+    using Vec3 = Vec3<double>;
+
+    for (int i = 0; i < n; i++) {
+        for (int k = 0; k < n; k++) {
+            Vec3 p00 = o + u * (i / double(n)) + v * (k / double(n));
+            Vec3 p10 = o + u * ((i + 1) / double(n)) + v * (k / double(n));
+            Vec3 p11 = o + u * ((i + 1) / double(n)) + v * ((k + 1) / double(n));
+            Vec3 p01 = o + u * (i / double(n)) + v * ((k + 1) / double(n));
+            faces.push_back({p00, p10, p11, nrcc::concrete});
+            faces.push_back({p00, p11, p01, nrcc::concrete});
+        }
+    }
+}
+
+void check(const std::string &name, const std::vector<Face<double>> &original, const Vec3<double> &tx,
+           const std::vector<Vec3<double>> &rxs) {
+    using Vec3 = Vec3<double>;
+    using Face = Face<double>;
+
+    std::vector<Face> welded = weld(original);
+    std::vector<std::vector<Vec3>> outlines;
+    std::vector<Face> merged = merge(welded, outlines);
+
+    uint64_t polygons = 0;
+    for (const auto &face: merged) polygons += face.outline != nullptr;
+
+    std::vector<Face> a = original;
+    std::vector<Face> b = merged;
+    std::cout << name << " faces read: " << original.size() << ", welded: " << welded.size() << ", merged: "
+              << merged.size() << " (" << polygons << " polygons)\n";
+    std::cout << name << " wedges read: " << edges(a).size() << ", merged: " << edges(b).size() << "\n";
+
+    Nrcc<double> rt;
+
+    std::vector<std::array<Vec3, 2>> segments;
+    for (const auto &rx: rxs) segments.push_back({tx, rx});
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<uint8_t> before;
+    for (const auto &segment: segments) before.push_back(rt.occluded(segment[0], segment[1], original));
+    auto stop = std::chrono::high_resolution_clock::now();
+    std::cout << name << " original time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+    start = std::chrono::high_resolution_clock::now();
+    std::vector<uint8_t> after;
+    for (const auto &segment: segments) after.push_back(rt.occluded(segment[0], segment[1], merged));
+    stop = std::chrono::high_resolution_clock::now();
+    std::cout << name << " merged time: " << duration_cast<std::chrono::microseconds>(stop - start).count() << "\n";
+
+    int mismatches = 0;
+    for (uint64_t i = 0; i < segments.size(); i++) mismatches += before[i] != after[i];
+    std::cout << name << " mismatches: " << mismatches << "\n";
+}
+
+int main() {
+    using Vec3 = Vec3<double>;
+    using Face = Face<double>;
+
+    std::cout << "face size: " << sizeof(Face) << " bytes, trivially copyable: "
+              << std::is_trivially_copyable_v<Face> << "\n";
+
+    std::vector<Vec3> rxs;
+    for (int i = -50; i < 50; i++) {
+        for (int k = -50; k < 50; k++) {
+            rxs.push_back({i * 0.8, 40.0, k * 0.8});
+        }
+    }
+    check("magnolia", read<double>((std::ifstream) "../data/magnolia.obj"), {0, -60, 10}, rxs);
+
+    std::vector<Face> block;
+    for (int bx = 0; bx < 3; bx++) {
+        for (int by = 0; by < 3; by++) {
+            Vec3 o = {bx * 30.0 - 40, by * 30.0 - 40, 0};
+            Vec3 x = {20, 0, 0};
+            Vec3 y = {0, 20, 0};
+            Vec3 z = {0, 0, 10.0 + 5 * bx + 3 * by};
+            wall(block, o, x, z, 6);
+            wall(block, o + y, z, x, 6);
+            wall(block, o, z, y, 6);
+            wall(block, o + x, y, z, 6);
+            wall(block, o + z, x, y, 6);
+        }
+    }
+    uint64_t tessellated = block.size();
+    for (uint64_t i = 0; i < tessellated; i += 7) block.push_back(block[i]);
+    for (uint64_t i = 0; i < tessellated; i += 11) {
+        block.push_back({block[i].points[0], block[i].points[1], block[i].points[1] + Vec3{0, 0, 1e-9}, nrcc::concrete});
+    }
+
+    std::vector<Vec3> street;
+    for (int i = -50; i < 50; i++) {
+        for (int k = 0; k < 50; k++) {
+            street.push_back({i * 1.0 + 0.37, -45.0 + k * 1.5 + 0.21, 1.5});
+        }
+    }
+    check("block", block, {-45, -45, 20}, street);
+
+    std::vector<std::vector<Vec3>> outlines;
+    Mesh<double> moving;
+    uint64_t group = moving.add(merge(weld(block), outlines), true);
+    outlines.clear();
+
+    uint64_t held = moving.groups[group].polygons.size();
+    for (int step = 0; step < 1000; step++) moving.translate(group, {step % 2 ? -0.5 : 0.5, 0, 0});
+    moving.refit();
+
+    Mesh<double> copy{moving};
+    moving = Mesh<double>{};
+
+    Mesh<double> reference{block};
+    Vec3 tx = {-45, -45, 20};
+    int mismatches = 0;
+    for (const auto &rx: street) mismatches += copy.occluded(tx, rx) != reference.occluded(tx, rx);
+    std::cout << "block moved 1000 steps: " << held << " polygons before, " << copy.groups[group].polygons.size()
+              << " after, copy mismatches: " << mismatches << "\n";
+
+    return 0;
+}